@@ -0,0 +1,124 @@
+"""Reader for the binary B&B trace files written by biqbin with parameter trace = 1.
+
+Every process writes <instance>.trace.<rank>. Usage:
+
+    python read_trace.py <instance>                 # summary over all ranks
+    python read_trace.py <instance> --csv out.csv   # all nodes as csv
+
+or from python:
+
+    from read_trace import read_trace
+    nodes = read_trace("tests/rudy/g05_100.4")      # list of dicts, sorted by start time
+"""
+import argparse
+import csv
+import glob
+import struct
+import sys
+from collections import defaultdict
+
+TRACE_MAGIC = b"BBTRACE\0"
+TRACE_VERSION = 1
+
+OUTCOMES = {0: "pruned", 1: "branched", 2: "giveup"}
+
+# TraceHeader and TraceRecord in src/biqbin.h
+HEADER = struct.Struct("<8s4i")
+RECORD = struct.Struct("<2q9d8i")
+RECORD_FIELDS = (
+    "id", "parent_id",
+    "parent_bound", "bound", "incumbent",
+    "t_start", "t_total", "t_ipm", "t_bundle", "t_heuristic", "t_separation",
+    "rank", "depth", "branch_var", "outcome", "num_tri", "num_pent", "num_hepta", "unused",
+)
+PHASES = ("ipm", "bundle", "heuristic", "separation")
+
+
+def read_trace_file(path):
+    """Reads one trace file and returns (header, records)."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, record_size, rank, num_vars = HEADER.unpack_from(data)
+    if magic != TRACE_MAGIC:
+        raise ValueError(f"{path} is not a biqbin trace file")
+    if version != TRACE_VERSION or record_size != RECORD.size:
+        raise ValueError(f"{path}: unsupported trace version {version}")
+
+    header = {"version": version, "rank": rank, "num_vars": num_vars}
+    records = [dict(zip(RECORD_FIELDS, r)) for r in RECORD.iter_unpack(data[HEADER.size:])]
+    return header, records
+
+
+def read_trace(instance):
+    """Reads the trace files of all ranks of instance, sorted by start time."""
+    paths = sorted(glob.glob(f"{instance}.trace.*"))
+    if not paths:
+        raise FileNotFoundError(f"no trace files {instance}.trace.*")
+
+    nodes = []
+    for path in paths:
+        nodes.extend(read_trace_file(path)[1])
+    nodes.sort(key=lambda r: r["t_start"])
+    return nodes
+
+
+def print_summary(nodes):
+    total = sum(r["t_total"] for r in nodes)
+    print(f"Nodes evaluated: {len(nodes)}")
+    for code, name in OUTCOMES.items():
+        print(f"  {name:10s} {sum(r['outcome'] == code for r in nodes)}")
+
+    print(f"\nEvaluation time: {total:.2f} s")
+    for phase in PHASES:
+        t = sum(r["t_" + phase] for r in nodes)
+        print(f"  {phase:10s} {t:10.2f} s ({100 * t / max(total, 1e-12):5.1f}%)")
+
+    by_rank = defaultdict(list)
+    by_depth = defaultdict(list)
+    for r in nodes:
+        by_rank[r["rank"]].append(r)
+        by_depth[r["depth"]].append(r)
+
+    print("\nPer rank:")
+    print(f"{'rank':>6} {'nodes':>8} {'time [s]':>10}")
+    for rank in sorted(by_rank):
+        rs = by_rank[rank]
+        print(f"{rank:6d} {len(rs):8d} {sum(r['t_total'] for r in rs):10.2f}")
+
+    print("\nPer depth:")
+    print(f"{'depth':>6} {'nodes':>8} {'pruned':>8} {'time [s]':>10} {'avg drop':>10} {'avg cuts':>10}")
+    for depth in sorted(by_depth):
+        rs = by_depth[depth]
+        # root has no parent bound (BIG_NUMBER)
+        drops = [r["parent_bound"] - r["bound"] for r in rs if r["parent_bound"] < 1e9]
+        cuts = [r["num_tri"] + r["num_pent"] + r["num_hepta"] for r in rs]
+        print(f"{depth:6d} {len(rs):8d} {sum(r['outcome'] == 0 for r in rs):8d} "
+              f"{sum(r['t_total'] for r in rs):10.2f} "
+              f"{sum(drops) / len(drops) if drops else 0.0:10.2f} {sum(cuts) / len(cuts):10.1f}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Summarize biqbin B&B trace files")
+    parser.add_argument("instance", help="instance path used when running biqbin")
+    parser.add_argument("--csv", help="write all nodes to this csv file")
+    args = parser.parse_args()
+
+    try:
+        nodes = read_trace(args.instance)
+    except (OSError, ValueError) as e:
+        print(e, file=sys.stderr)
+        return 1
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=RECORD_FIELDS)
+            writer.writeheader()
+            writer.writerows(nodes)
+    else:
+        print_summary(nodes)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
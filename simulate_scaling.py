@@ -0,0 +1,363 @@
+"""Discrete-event simulator of the biqbin master/worker protocol.
+
+Predicts how a B&B tree is processed on an arbitrary number of MPI ranks
+without running the solver. The tree is either replayed from trace files
+(parameter trace = 1, see read_trace.py) or generated synthetically.
+
+The message protocol follows wrapped_main, master_Bab_Main and worker_Bab_Main:
+
+  * rank 0 evaluates the root, broadcasts diff/over/lower bound, branches the
+    root and sends the two children to workers 1 and 2,
+  * a worker evaluates nodes of its local queue (best bound first); after a
+    better solution it sends NEW_VALUE and waits for the global lower bound,
+    after branching it asks the master for free workers (SEND_FREEWORKERS),
+    waits for the answer and sends nodes from its queue to the free workers,
+  * a worker with an empty queue sends IDLE; the master stops all workers when
+    every worker is idle.
+
+The master serves one message at a time. Every message costs
+latency + bytes / bandwidth; the sender is busy for bytes / bandwidth.
+
+Usage:
+
+    python simulate_scaling.py --trace tests/rudy/g05_100.4 --ranks 3,16,64,1024
+    python simulate_scaling.py --synthetic --nodes 200000 --ranks 64,256,1024,4096
+"""
+import argparse
+import heapq
+import math
+import random
+import sys
+
+# message sizes in bytes (NMAX = 1024, see biqbin_cpp_api.h)
+NMAX = 1024
+SIZE_INT = 4
+SIZE_DOUBLE = 8
+SIZE_SOLUTION = NMAX * SIZE_INT
+SIZE_NODE = NMAX * SIZE_INT + SIZE_SOLUTION + NMAX * SIZE_DOUBLE + 40
+
+
+class Node:
+    """Node of the B&B tree: computed bound, evaluation time, incumbent after evaluation."""
+    __slots__ = ("id", "bound", "eval_time", "incumbent", "children")
+
+    def __init__(self, id, bound, eval_time, incumbent, children=None):
+        self.id = id
+        self.bound = bound
+        self.eval_time = eval_time
+        self.incumbent = incumbent
+        self.children = children
+
+
+class TraceTree:
+    """Tree recorded with trace = 1. Nodes that were not evaluated are dropped."""
+
+    def __init__(self, instance):
+        from read_trace import read_trace
+
+        records = read_trace(instance)
+        self.nodes = {}
+        children = {}
+        for r in records:
+            self.nodes[r["id"]] = Node(r["id"], r["bound"], r["t_total"], r["incumbent"])
+            children.setdefault(r["parent_id"], []).append(r["id"])
+        for id, node in self.nodes.items():
+            node.children = children.get(id, [])
+        self.root = children[-1][0]
+        self.initial_incumbent = min(r["incumbent"] for r in records)
+
+    def node(self, id):
+        return self.nodes[id]
+
+    def children(self, node):
+        return node.children
+
+
+class SyntheticTree:
+    """
+    Random tree: each level decreases the bound by an exponentially distributed
+    amount, a node is pruned when its bound drops below the optimum + 1.
+    Evaluation times are lognormal. The incumbent is the optimum from the start.
+    The tree is generated breadth first before the simulation, so it does not
+    depend on the order in which the simulated ranks visit the nodes.
+    """
+
+    def __init__(self, gap, mean_drop, mean_time, max_nodes, seed):
+        self.rng = random.Random(seed)
+        self.optimum = 0.0
+        self.mean_drop = mean_drop
+        self.mean_time = mean_time
+        self.initial_incumbent = self.optimum
+        self.root = Node(0, gap, self._time(), self.optimum, [])
+
+        num_nodes = 1
+        level = [self.root]
+        while level:
+            next_level = []
+            for node in level:
+                if node.bound < self.optimum + 1.0 or num_nodes + 2 > max_nodes:
+                    continue
+                for _ in range(2):
+                    bound = node.bound - self.rng.expovariate(1.0 / self.mean_drop)
+                    child = Node(num_nodes, bound, self._time(), self.optimum, [])
+                    node.children.append(child)
+                    next_level.append(child)
+                    num_nodes += 1
+            level = next_level
+        self.num_nodes = num_nodes
+
+    def _time(self):
+        sigma = 0.5
+        return self.rng.lognormvariate(math.log(self.mean_time) - sigma * sigma / 2, sigma)
+
+    def node(self, node):
+        return node
+
+    def children(self, node):
+        return node.children
+
+
+class Simulator:
+
+    def __init__(self, tree, num_ranks, latency, bandwidth, master_time, min_donation_gap):
+        self.tree = tree
+        self.p = num_ranks
+        self.latency = latency
+        self.bandwidth = bandwidth
+        self.master_time = master_time
+        self.min_donation_gap = min_donation_gap
+
+        self.events = []
+        self.seq = 0
+        self.now = 0.0
+
+        # master
+        self.master_queue = []          # messages waiting at the master
+        self.master_serving = False
+        self.master_busy = 0.0
+        self.global_lb = tree.initial_incumbent
+        self.free = [True] * num_ranks  # busyWorkers
+        self.num_free = num_ranks - 1
+        self.queue_area = 0.0           # integral of master queue depth over time
+        self.queue_max = 0
+        self.queue_last = 0.0
+        self.messages = 0
+
+        # workers
+        self.local = [[] for _ in range(num_ranks)]     # local priority queues (-key, seq, id)
+        self.lb = [tree.initial_incumbent] * num_ranks
+        self.working = [False] * num_ranks
+        self.eval_time = [0.0] * num_ranks
+        self.comm_time = [0.0] * num_ranks              # blocked on answers of the master
+        self.pending = {}                               # node waiting for NEW_VALUE answer
+        self.evaluated = 0
+
+    # ---------- event handling ----------
+
+    def schedule(self, time, action, *args):
+        self.seq += 1
+        heapq.heappush(self.events, (time, self.seq, action, args))
+
+    def cost(self, size):
+        return self.latency + size / self.bandwidth
+
+    def send(self, sizes, action, *args, delay=0.0):
+        """Send consecutive messages after delay, action is called when the last one arrives."""
+        self.messages += len(sizes)
+        arrival = self.now + delay + sum(s / self.bandwidth for s in sizes) + self.latency
+        self.schedule(arrival, action, *args)
+
+    def run(self):
+        # root evaluated by master, then broadcasts (binomial tree)
+        root = self.tree.node(self.tree.root)
+        self.evaluated += 1
+        self.now = root.eval_time
+        self.global_lb = max(self.global_lb, root.incumbent)
+        children = self.tree.children(root)
+        bcast = math.ceil(math.log2(max(self.p, 2))) * self.cost(SIZE_DOUBLE)
+        self.now += 3 * bcast
+
+        for i, child in enumerate(children[:2]):
+            worker = i + 1
+            if worker >= self.p:
+                break
+            self.free[worker] = False
+            self.num_free -= 1
+            self.send([SIZE_INT, SIZE_DOUBLE, SIZE_NODE], self.worker_receive, worker, child, root.bound)
+
+        while self.events:
+            time, _, action, args = heapq.heappop(self.events)
+            self.now = time
+            action(*args)
+        self.makespan = self.now
+        return self
+
+    # ---------- master ----------
+
+    def master_enqueue(self, kind, source, payload):
+        self.track_queue()
+        self.master_queue.append((kind, source, payload))
+        self.queue_max = max(self.queue_max, len(self.master_queue))
+        if not self.master_serving:
+            self.master_serving = True
+            self.schedule(self.now, self.master_serve)
+
+    def track_queue(self):
+        self.queue_area += len(self.master_queue) * (self.now - self.queue_last)
+        self.queue_last = self.now
+
+    def master_serve(self):
+        """Take the next message, its answer is sent after master_time."""
+        self.track_queue()
+        message = self.master_queue.pop(0)
+        self.master_busy += self.master_time
+        self.schedule(self.now + self.master_time, self.master_done, *message)
+
+    def master_done(self, kind, source, payload):
+        if kind == "IDLE":
+            self.free[source] = True
+            self.num_free += 1
+        elif kind == "NEW_VALUE":
+            self.global_lb = max(self.global_lb, payload)
+            self.send([SIZE_DOUBLE], self.worker_value_reply, source, self.global_lb)
+        elif kind == "SEND_FREEWORKERS":
+            available = []
+            for w in range(1, self.p):
+                if len(available) == min(payload, self.num_free):
+                    break
+                if self.free[w]:
+                    available.append(w)
+                    self.free[w] = False
+            self.num_free -= len(available)
+            self.send([SIZE_INT, SIZE_INT * max(len(available), 1), SIZE_DOUBLE],
+                      self.worker_freeworkers_reply, source, available, self.global_lb)
+
+        if self.master_queue:
+            self.master_serve()
+        else:
+            self.master_serving = False
+
+    # ---------- worker ----------
+
+    def push(self, w, node, key):
+        self.seq += 1
+        heapq.heappush(self.local[w], (-key, self.seq, node))
+
+    def worker_receive(self, w, node, key):
+        self.push(w, node, key)
+        if not self.working[w]:
+            self.working[w] = True
+            self.worker_next(w)
+
+    def worker_next(self, w):
+        if not self.local[w]:
+            self.working[w] = False
+            self.send([SIZE_INT], self.master_enqueue, "IDLE", w, None)
+            return
+        _, _, id = heapq.heappop(self.local[w])
+        node = self.tree.node(id)
+        self.eval_time[w] += node.eval_time
+        self.evaluated += 1
+        self.schedule(self.now + node.eval_time, self.worker_evaluated, w, node)
+
+    def worker_evaluated(self, w, node):
+        if node.incumbent > self.lb[w]:
+            self.lb[w] = node.incumbent
+            self.comm_time[w] -= self.now
+            self.send([SIZE_INT, SIZE_DOUBLE, SIZE_SOLUTION], self.master_enqueue, "NEW_VALUE", w, node.incumbent)
+            self.pending[w] = node
+            return
+        self.worker_branch(w, node)
+
+    def worker_value_reply(self, w, lb):
+        self.comm_time[w] += self.now
+        self.lb[w] = max(self.lb[w], lb)
+        self.worker_branch(w, self.pending.pop(w))
+
+    def worker_branch(self, w, node):
+        children = self.tree.children(node)
+        if not children:
+            self.worker_next(w)
+            return
+        for child in children:
+            self.push(w, child, node.bound)
+        # countDonatableNodes: everything except the top of the heap
+        if self.min_donation_gap > 0:
+            request = sum(1 for key, _, _ in self.local[w][1:] if -key - self.lb[w] >= self.min_donation_gap)
+        else:
+            request = len(self.local[w]) - 1
+        self.comm_time[w] -= self.now
+        self.send([SIZE_INT, SIZE_INT], self.master_enqueue, "SEND_FREEWORKERS", w, request)
+
+    def worker_freeworkers_reply(self, w, available, lb):
+        self.comm_time[w] += self.now
+        self.lb[w] = max(self.lb[w], lb)
+        # popDonationNode: at most heap size - 1 workers were requested
+        delay = 0.0
+        for target in available:
+            key, _, child = heapq.heappop(self.local[w])
+            self.send([SIZE_INT, SIZE_DOUBLE, SIZE_NODE], self.worker_receive, target, child, -key, delay=delay)
+            delay += SIZE_NODE / self.bandwidth
+        self.comm_time[w] += delay
+        self.schedule(self.now + delay, self.worker_next, w)
+
+    # ---------- report ----------
+
+    def report(self):
+        workers = self.p - 1
+        span = self.makespan
+        busy = sum(self.eval_time)
+        comm = sum(self.comm_time)
+        return {
+            "ranks": self.p,
+            "nodes": self.evaluated,
+            "time": span,
+            "utilization": busy / (workers * span) if span > 0 else 0.0,
+            "idle": workers * span - busy - comm,
+            "comm": comm,
+            "master_busy": self.master_busy / span if span > 0 else 0.0,
+            "queue_avg": self.queue_area / span if span > 0 else 0.0,
+            "queue_max": self.queue_max,
+            "messages": self.messages,
+        }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate biqbin master/worker scaling")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--trace", metavar="INSTANCE", help="replay trace files <INSTANCE>.trace.*")
+    source.add_argument("--synthetic", action="store_true", help="use a random tree")
+    parser.add_argument("--ranks", default="3,16,64,256,1024", help="comma separated number of ranks")
+    parser.add_argument("--latency", type=float, default=2e-6, help="message latency [s]")
+    parser.add_argument("--bandwidth", type=float, default=10e9, help="bandwidth [bytes/s]")
+    parser.add_argument("--master-time", type=float, default=2e-6, help="master time per message [s]")
+    parser.add_argument("--min-donation-gap", type=float, default=0.0,
+                        help="donate only nodes with bound - lower bound >= gap")
+    parser.add_argument("--nodes", type=int, default=100000, help="synthetic: maximum number of nodes")
+    parser.add_argument("--gap", type=float, default=40.0, help="synthetic: root gap")
+    parser.add_argument("--drop", type=float, default=3.0, help="synthetic: mean bound decrease per level")
+    parser.add_argument("--eval-time", type=float, default=0.5, help="synthetic: mean evaluation time [s]")
+    parser.add_argument("--seed", type=int, default=2020)
+    args = parser.parse_args()
+
+    print(f"{'ranks':>7} {'nodes':>9} {'time [s]':>11} {'util':>6} {'idle [s]':>11} {'comm [s]':>10} "
+          f"{'master':>7} {'queue avg':>10} {'queue max':>10} {'messages':>10}")
+
+    for p in (int(r) for r in args.ranks.split(",")):
+        if p < 3:
+            print(f"{p:7d}  at least 3 ranks (master + 2 workers) required", file=sys.stderr)
+            continue
+        if args.trace:
+            tree = TraceTree(args.trace)
+        else:
+            tree = SyntheticTree(args.gap, args.drop, args.eval_time, args.nodes, args.seed)
+
+        r = Simulator(tree, p, args.latency, args.bandwidth, args.master_time, args.min_donation_gap).run().report()
+        print(f"{r['ranks']:7d} {r['nodes']:9d} {r['time']:11.2f} {r['utilization']:6.2f} {r['idle']:11.1f} "
+              f"{r['comm']:10.3f} {r['master_busy']:7.3f} {r['queue_avg']:10.3f} {r['queue_max']:10d} "
+              f"{r['messages']:10d}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
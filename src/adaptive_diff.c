@@ -0,0 +1,91 @@
+/* Estimates of the bound improvement by cutting planes (params.adaptive_diff) */
+
+/*
+ * With params.use_diff a worker gives up on a node without adding cutting
+ * planes if its basic bound is above LB + diff + 1, where diff is the
+ * improvement of the cutting planes in the root. The improvement shrinks
+ * deeper in the tree and depends on the size of the subproblem, so with
+ * params.adaptive_diff the improvement (basic bound - final bound) of every
+ * node that ran the cutting plane algorithm is recorded per depth range and
+ * range of the number of free variables in the shared statistics
+ * (shared_stats.c).
+ *
+ * The threshold of a node is mean + standard deviation of the improvements
+ * in its range, shrunk towards the root value diff with weight
+ * ADAPTIVE_DIFF_PRIOR: ranges without observations use diff.
+ */
+
+#include <math.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern double diff;
+
+#define ADAPTIVE_DIFF_SIZES 4       // quarters of the free variables
+#define ADAPTIVE_DIFF_PRIOR 5.0     // weight of the root value diff (in observations)
+
+/* layout in shared statistics: sum, sum of squares and count of improvements per range */
+static int ad_offset = -1;
+
+#define AD_SUM(r)   (ad_offset + (r) * 3)
+#define AD_SUMSQ(r) (AD_SUM(r) + 1)
+#define AD_COUNT(r) (AD_SUM(r) + 2)
+
+
+/* range of depth and number of free variables of node */
+static int improvementRange(BabNode *node) {
+
+    int depth = SharedStats_DepthRange(node->level);
+
+    int free_vars = BabPbSize - countFixedVariables(node);
+    int size = (ADAPTIVE_DIFF_SIZES * free_vars) / (BabPbSize + 1);
+
+    return depth * ADAPTIVE_DIFF_SIZES + size;
+}
+
+
+void initAdaptiveDiff(void) {
+
+    if (params.use_diff && params.adaptive_diff)
+        ad_offset = SharedStats_Register(3 * SHARED_STATS_DEPTH_RANGES * ADAPTIVE_DIFF_SIZES);
+}
+
+
+/* record improvement of the cutting planes at node: basic bound -> bound */
+void recordCutImprovement(BabNode *node, double basic_bound, double bound) {
+
+    if (ad_offset < 0)
+        return;
+
+    // the bundle method can stop with a bound above the basic bound
+    double improvement = basic_bound - bound;
+    improvement = (improvement > 0.0) ? improvement : 0.0;
+
+    int r = improvementRange(node);
+    SharedStats_Add(AD_SUM(r), improvement);
+    SharedStats_Add(AD_SUMSQ(r), improvement * improvement);
+    SharedStats_Add(AD_COUNT(r), 1.0);
+}
+
+
+/* expected improvement of the cutting planes at node, node gives up if the basic bound is above LB + this + 1 */
+double expectedCutImprovement(BabNode *node) {
+
+    if (ad_offset < 0)
+        return diff;
+
+    const double *stats = SharedStats_Get(0);
+    int r = improvementRange(node);
+    double count = stats[AD_COUNT(r)];
+
+    if (count == 0.0)
+        return diff;
+
+    double mean = stats[AD_SUM(r)] / count;
+    double var = stats[AD_SUMSQ(r)] / count - mean * mean;
+    double estimate = mean + ((var > 0.0) ? sqrt(var) : 0.0);
+
+    return (ADAPTIVE_DIFF_PRIOR * diff + count * estimate) / (ADAPTIVE_DIFF_PRIOR + count);
+}
@@ -31,6 +31,7 @@ void allocMemory(void) {
     alloc_matrix(Z, N, double);
     alloc_vector(X_bundle, N * N * MaxBundle, double);
     alloc_matrix(X_test, N, double);
+    alloc_matrix(L_eval, N, double);
     alloc_vector(dual_gamma, MaxTriIneqAdded + MaxPentIneqAdded + MaxHeptaIneqAdded, double);
     alloc_vector(dgamma, MaxTriIneqAdded + MaxPentIneqAdded + MaxHeptaIneqAdded, double);
     alloc_vector(gamma_test, MaxTriIneqAdded + MaxPentIneqAdded + MaxHeptaIneqAdded, double);
@@ -64,6 +65,7 @@ void freeMemory(void) {
     free(Z);
     free(X_bundle);
     free(X_test);
+    free(L_eval);
     free(dual_gamma);
     free(dgamma);
     free(gamma_test);
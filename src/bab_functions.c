@@ -14,19 +14,46 @@ extern BabSolution *BabSol;
 extern BiqBinParameters params;
 extern Problem *SP;
 extern Problem *PP;
+extern double *X;
+extern double *dual_gamma;
 
 extern double root_bound;
 extern double TIME;
 extern int stopped;
 
 extern int num_workers_used;
+extern EvalStats eval_stats;
+extern double granularity;
+extern int num_strong_branchings;
+extern int num_strong_changes;
+
+static int countDonatableNodes(void);
+static BabNode* popDonationNode(void);
+static BabNode* popDeepestNode(void);
+
 int max_depth = 0;
+int num_pair_branchings = 0;    // nodes branched on a pair of variables (summed over all processes at the end)
+
 void inc_max_depth(int d) {
     if (max_depth < d) {
         max_depth = d;
     }
 }
 
+/* returns 1 if the time limit is set and reached */
+int timeLimitReached(void) {
+    return params.time_limit > 0 && (MPI_Wtime() - TIME) > params.time_limit;
+}
+
+
+/* returns 1 in the last params.dive_time seconds before the time limit:
+ * the search then favors diving and heuristics to improve the incumbent */
+int diveModeActive(void) {
+    return params.time_limit > 0 && params.dive_time > 0 && 
+           (MPI_Wtime() - TIME) > params.time_limit - params.dive_time;
+}
+
+
 /* initialize global lower bound to 0 and global solution vector to zero */
 void initializeBabSolution() { 
 
@@ -48,11 +75,13 @@ int Init_PQ(void) {
 
     // Create the root node
     BabRoot = newNode(NULL);
+    BabRoot->id = Trace_NextId();
 
     // increase number of evaluated nodes
     Bab_incEvalNodes();
 
     // Evaluate root node: compute upper and lower bound 
+    double t_start = MPI_Wtime();
     root_bound = Evaluate(BabRoot, SP, PP, 0);
     printf("Root node bound: %.2f\n", root_bound);
 
@@ -60,13 +89,18 @@ int Init_PQ(void) {
     BabRoot->upper_bound = root_bound;
 
     /* insert node into the priority queue or prune */
-    // NOTE: optimal solution has INTEGER value, i.e. add +1 to lower bound
-    if (Bab_LBGet() + 1.0 < BabRoot->upper_bound) {    
+    // NOTE: objective values are multiples of granularity, i.e. add granularity to lower bound
+    if (Bab_LBGet() + granularity < BabRoot->upper_bound) {    
+        if (params.trace)
+            Trace_Node(BabRoot, BIG_NUMBER, t_start, eval_stats.gave_up ? TRACE_GIVEUP : TRACE_BRANCHED);
+        setNodePriority(BabRoot);
         Bab_PQInsert(BabRoot); 
     }
     else {
         // otherwise, intbound <= BabLB, so we can prune
         over = -1;
+        if (params.trace)
+            Trace_Node(BabRoot, BIG_NUMBER, t_start, TRACE_PRUNED);
         free(BabRoot);
     }
 
@@ -83,9 +117,33 @@ int Bab_Init(int argc, char **argv, int rank) {
     if ( (read_error = processCommandLineArguments(argc, argv, rank)) )
         return read_error;
 
+    // models of the learned scorer (branchingStrategy = LEARNED_SCORE, node_selection = 1)
+    if ( (read_error = loadScorer(argv[2], rank)) )
+        return read_error;
+
     // Seed the random number generator
     srand(2020);
 
+    // every process writes its own trace file
+    Trace_Open(argv[1], rank);
+
+    // register statistics shared by all processes
+    initPseudoCosts();
+    initCutControl();
+    initAdaptiveDiff();
+
+    // buffers of the helper thread of pipelined node evaluation
+    initPipeline();
+
+    // automorphisms of the problem for orbital branching
+    initSymmetry(rank);
+
+    // sparse storage of the Laplacian for sparse graphs
+    initSparse(rank);
+
+    // lattice of the objective values for pruning
+    computeGranularity(rank);
+
     // Provide B&B with an initial solution
     initializeBabSolution();
 
@@ -95,12 +153,75 @@ int Bab_Init(int argc, char **argv, int rank) {
     return read_error;
 }
 
+/*
+ * Objective lattice: evaluateSolution(x) = sum_i L[i][i] x[i] + sum_{i<j} 2 L[i][j] x[i] x[j]
+ * for x in {0,1}^BabPbSize, so all values are multiples of the gcd of these
+ * coefficients. The gcd is also attained: L[i][i] and 2 L[i][j] are values or
+ * differences of values (e_i, e_i + e_j), so x = 0 with value 0 fixes the
+ * parity and there is no coarser lattice. Nodes are pruned if
+ * bound < LB + granularity. If some coefficient is not integer, granularity
+ * stays 1 (integer objective values are assumed as before).
+ */
+void computeGranularity(int rank) {
+
+    long long gcd = 0;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        for (int j = i; j < BabPbSize; ++j) {
+
+            double coeff = fabs((i == j) ? SP->L[i + i * SP->n] : 2.0 * SP->L[j + i * SP->n]);
+            double rounded = round(coeff);
+
+            if (fabs(coeff - rounded) > LATTICE_EPS * (1.0 + coeff) || rounded > 1e15)
+                return;
+
+            // gcd(gcd, rounded)
+            long long a = (long long) rounded;
+            while (a != 0) {
+                long long r = gcd % a;
+                gcd = a;
+                a = r;
+            }
+        }
+    }
+
+    if (gcd > 1) {
+        granularity = (double) gcd;
+        if (rank == 0)
+            printf("Objective values are multiples of %.0lf\n", granularity);
+    }
+}
+
+
+/* largest multiple of granularity that is at most bound (up to rounding errors) */
+double latticeFloor(double bound) {
+
+    if (granularity == 1.0 || bound >= BIG_NUMBER)
+        return bound;
+
+    return granularity * floor(bound / granularity + LATTICE_EPS);
+}
+
+
 /* NOTE: int *sol in functions evaluateSolution and updateSolution have length BabPbSize
  * -> to get objecive multiple with Laplacian that is stored in upper left corner of SP->L
  */
 double evaluateSolution(int *sol) {
 
     double val = 0.0;
+    const SparseMatrix *S = sparseLaplacian();
+
+    if (S != NULL) {
+        // only rows of vertices with sol[i] = 1 contribute
+        for (int i = 0; i < BabPbSize; ++i) {
+            if (sol[i]) {
+                val += S->diag[i];
+                for (int e = S->row_start[i]; e < S->row_start[i + 1]; ++e)
+                    val += S->val[e] * sol[S->col[e]];
+            }
+        }
+        return val;
+    }
     
     for (int i = 0; i < BabPbSize; ++i) {
         for (int j = 0; j < BabPbSize; ++j) {
@@ -143,7 +264,7 @@ int updateSolution(int *x) {
 void master_Bab_Main(Message message, int source, int *busyWorkers, int numbWorkers, int *numbFreeWorkers, MPI_Datatype BabSolutiontype) {
 
     // If the algorithm stops before finding the optimal solution
-    if (!stopped && (params.time_limit > 0 && (MPI_Wtime() - TIME) > params.time_limit) ) {
+    if (!stopped && timeLimitReached()) {
         
         // signal to printFinalOutput that algorihtm stopped early
         stopped = 1;        
@@ -179,6 +300,11 @@ void master_Bab_Main(Message message, int source, int *busyWorkers, int numbWork
             MPI_Send(&g_lowerBound, 1, MPI_DOUBLE, source, LOWER_BOUND, MPI_COMM_WORLD);
             break;       
         }
+        case SYNC_STATS:
+
+            SharedStats_MasterSync(source);
+            break;
+
         case SEND_FREEWORKERS:
         {            
             // get number of requested workers            
@@ -232,15 +358,27 @@ void worker_Bab_Main(MPI_Datatype BabSolutiontype, MPI_Datatype BabNodetype, int
     MPI_Status status;
     int over = 0;
 
-    // get next subproblem from priority queue
-    BabNode *node = Bab_PQPop();
+    // get next subproblem from priority queue,
+    // close to the time limit dive: take the deepest node
+    BabNode *node = diveModeActive() ? popDeepestNode() : Bab_PQPop();
 
     // save "old" lower bound
     double g_lowerBound = Bab_LBGet();
 
+    // bound inherited from the parent node
+    double parent_bound = node->upper_bound;
+    double t_start = MPI_Wtime();
+
     /* compute upper bound (SDP bound) and lower bound (via heuristic) for this node */
     node->upper_bound = Evaluate(node, SP, PP, rank);
 
+    // an evaluation that gave up early can stop above the pre-bound
+    if (node->prebound < node->upper_bound)
+        node->upper_bound = node->prebound;
+
+    recordBoundDrop(node->level, parent_bound, node->upper_bound);
+    recordNodePseudoCost(node, parent_bound);
+
     // check if better lower bound found --> update info with master
     if (Bab_LBGet() > g_lowerBound){
 
@@ -259,40 +397,54 @@ void worker_Bab_Main(MPI_Datatype BabSolutiontype, MPI_Datatype BabNodetype, int
     }
 
 
-    /* if BabLB + 1.0 < child_node->upper_bound, 
+    /* if BabLB + granularity < child_node->upper_bound, 
      * then we must branch since there could be a better feasible 
      * solution in this subproblem
      */
-    if (Bab_LBGet() + 1.0 < node->upper_bound) {
+    if (Bab_LBGet() + granularity < node->upper_bound) {
 
         /***** branch *****/
+        recordNodeOutcome(1);
 
-        // Determine the variable x[ic] to branch on
-        int ic = getBranchingVariable(node);
+        // cuts and multipliers of the node, branching decisions overwrite them
+        CutPool *pool = (params.child_prebound) ? saveCuts(node, PP, dual_gamma) : NULL;
 
-        BabNode *child_node; 
-        
-        for (int xic = 0; xic <= 1; ++xic) { 
+        // Split node into two children
+        BabNode *children[2];
+        createChildren(node, children);
 
-            // Create a new child node from the parent node
-            child_node = newNode(node);
+        /* insert nodes into the priority queue */
+        for (int c = 0; c <= 1; ++c) {
 
-            // split on node ic
-            child_node->xfixed[ic] = 1;
-            child_node->sol.X[ic] = xic;
+            // children with a small pre-bound are pruned without being queued
+            if (pool != NULL) {
+                double bound = childPreBound(children[c], pool, SP, PP);
+                if (bound < Bab_LBGet() + granularity) {
+                    free(children[c]);
+                    continue;
+                }
+                // upper_bound stays the bound of the parent (bound drops, pseudo-costs, trace)
+                if (bound < children[c]->prebound)
+                    children[c]->prebound = bound;
+            }
 
-            /* insert node into the priority queue */
-            Bab_PQInsert(child_node);
+            setNodePriority(children[c]);
+            Bab_PQInsert(children[c]);
         }
 
+        if (pool != NULL)
+            freeCutPool(pool);
+
         // free parent node
         inc_max_depth(node->level);
+        if (params.trace)
+            Trace_Node(node, parent_bound, t_start, eval_stats.gave_up ? TRACE_GIVEUP : TRACE_BRANCHED);
         free(node); 
 
         /************ distribute subproblems ************/
 
         // leave 1 problem for this worker and the rest is distributed
-        int workers_request = heap->used - 1;
+        int workers_request = countDonatableNodes();
         int num_free_workers;
         double g_lowerBound;
         BabSolution solx;
@@ -318,7 +470,7 @@ void worker_Bab_Main(MPI_Datatype BabSolutiontype, MPI_Datatype BabNodetype, int
             for (int i = 0; i < num_free_workers; ++i){
 
                 // get next subproblem from queue and send it
-                node = Bab_PQPop();
+                node = popDonationNode();
 
                 // send subproblem to free worker
                 MPI_Send(&over, 1, MPI_INT, free_workers[i], OVER, MPI_COMM_WORLD);
@@ -332,12 +484,75 @@ void worker_Bab_Main(MPI_Datatype BabSolutiontype, MPI_Datatype BabNodetype, int
     }
     else {
         // otherwise, intbound <= BabLB, so we can prune
+        recordNodeOutcome(0);
+        if (params.trace)
+            Trace_Node(node, parent_bound, t_start, TRACE_PRUNED);
         free(node);
     }
 
+    // exchange shared statistics (pseudo-costs) with master
+    SharedStats_NodeDone();
+
 }  
 
 
+/* Number of nodes in the local queue that are sent to free workers.
+ * The node on top of the heap always stays with this worker. */
+static int countDonatableNodes(void) {
+
+    // queue can be empty if both children were pruned by their pre-bounds
+    if (params.donation_strategy != DONATE_LARGEST_SUBTREE)
+        return (heap->used > 0) ? heap->used - 1 : 0;
+
+    // only nodes with large expected subtrees are worth the communication
+    int count = 0;
+    for (int i = 1; i < heap->used; ++i) {
+        if (estimateSubtreeSize(heap->data[i]) >= params.min_donation_size)
+            ++count;
+    }
+
+    return count;
+}
+
+
+/* Take the deepest node (ties: largest upper bound) out of the local queue */
+static BabNode* popDeepestNode(void) {
+
+    int best = 0;
+
+    for (int i = 1; i < heap->used; ++i) {
+        if (heap->data[i]->level > heap->data[best]->level ||
+            (heap->data[i]->level == heap->data[best]->level &&
+             heap->data[i]->upper_bound > heap->data[best]->upper_bound))
+            best = i;
+    }
+
+    return Heap_Remove(heap, best);
+}
+
+
+/* Take the next node to be sent to a free worker out of the local queue */
+static BabNode* popDonationNode(void) {
+
+    if (params.donation_strategy != DONATE_LARGEST_SUBTREE)
+        return Bab_PQPop();
+
+    // node with the largest estimated subtree (except top of the heap)
+    int best = 1;
+    double best_size = -BIG_NUMBER;
+
+    for (int i = 1; i < heap->used; ++i) {
+        double size = estimateSubtreeSize(heap->data[i]);
+        if (size > best_size) {
+            best_size = size;
+            best = i;
+        }
+    }
+
+    return Heap_Remove(heap, best);
+}
+
+
 
 
 /* print solution 0-1 vector */
@@ -360,6 +575,11 @@ void printFinalOutput(FILE *file, int num_nodes) {
     double best_sol = Bab_LBGet();
 
     fprintf(file, "\nNodes = %d\n", num_nodes);
+    if (params.pair_branching)
+        fprintf(file, "Pair branchings = %d\n", num_pair_branchings);
+    if (params.branchingStrategy == STRONG_BRANCHING)
+        fprintf(file, "Strong branchings = %d (%d not on the most fractional variable)\n",
+                num_strong_branchings, num_strong_changes);
     
     // normal termination
     if (!stopped) {
@@ -380,6 +600,14 @@ void printFinalOutput(FILE *file, int num_nodes) {
 /* Bab function called at the end of the execution.
  * This function frees the memory allocated by the program. */
 void Bab_End(void) {
+    Trace_Close();
+    SharedStats_Free();
+    CutCache_Free();
+    freeSymmetry();
+    freeSubproblemCache();
+    freeSparse();
+    freePipeline();
+    freeIPMWorkspace();
     freeMemory();   
 }
 
@@ -418,6 +646,18 @@ int getBranchingVariable(BabNode *node) {
             }
         }
     }
+    else if (params.branchingStrategy == STRONG_BRANCHING) {
+        // Branch on the variable with the best truncated bounds of both children
+        ic = strongBranchingVariable(node);
+    }
+    else if (params.branchingStrategy == PSEUDO_COST) {
+        // Branch on the variable with the best pseudo-costs (strong branching if unreliable)
+        ic = pseudoCostBranchingVariable(node);
+    }
+    else if (params.branchingStrategy == LEARNED_SCORE) {
+        // Branch on the variable with the best score of the model loaded by loadScorer
+        ic = learnedBranchingVariable(node);
+    }
     else {
         fprintf(stderr, "Error: Wrong value for params.branchingStrategy\n");
         MPI_Abort(MPI_COMM_WORLD,10);
@@ -427,6 +667,115 @@ int getBranchingVariable(BabNode *node) {
 }
 
 
+/*
+ * Pair branching: find free variables x[i], x[j] (i < j) of the subproblem
+ * with params.pair_threshold <= |X_ij| such that |X_ij| is the smallest,
+ * i.e. the relaxation leans to x[i] = x[j] (X_ij > 0) or x[i] != x[j]
+ * (X_ij < 0) but both children still move the bound. The largest |X_ij|
+ * gives a child with the bound of the parent and a child that is pruned at
+ * once, which only adds a level to the tree.
+ * Returns 1 if such a pair exists.
+ *
+ * Must be called directly after the node was evaluated (uses X and PP).
+ */
+static int getBranchingPair(BabNode *node, int *i_pair, int *j_pair) {
+
+    int n = PP->n;
+    int sub_to_orig[n];
+    int index = 0;
+    double bestValue = BIG_NUMBER;
+    int a_best = -1, b_best = -1;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (!node->xfixed[i])
+            sub_to_orig[index++] = i;
+    }
+
+    // last vertex of the subproblem is not a variable
+    for (int a = 0; a < n - 1; ++a) {
+        for (int b = a + 1; b < n - 1; ++b) {
+            double value = fabs(X[b + a*n]);
+            if (value >= params.pair_threshold && value < bestValue) {
+                bestValue = value;
+                a_best = a;
+                b_best = b;
+            }
+        }
+    }
+
+    if (a_best < 0)
+        return 0;
+
+    *i_pair = sub_to_orig[a_best];
+    *j_pair = sub_to_orig[b_best];
+
+    return 1;
+}
+
+
+/*
+ * Create the two children of node, must be called directly after the node was evaluated.
+ * Variables are first fixed in node with the dual information (params.dual_fixing).
+ * Pair branching (params.pair_branching) links x[j] to x[i]: x[j] = x[i] in the
+ * first and x[j] != x[i] in the second child, otherwise the branching variable
+ * x[ic] is fixed to 0 and 1. With params.symmetry, the child with x[ic] != v
+ * (v = rounded x[ic]) fixes the whole orbit of x[ic] (orbital branching).
+ */
+void createChildren(BabNode *node, BabNode *children[2]) {
+
+    int i, j;
+
+    // pair is chosen first: dual fixing and strong branching overwrite X
+    int pair = params.pair_branching && getBranchingPair(node, &i, &j);
+    Scorer_StoreColumnStats(node);
+
+    // fix variables in node, both children inherit the fixings
+    if (params.dual_fixing > 0)
+        dualFixing(node, params.dual_fixing);
+
+    if (pair && !node->xfixed[i] && !node->xfixed[j]) {
+
+        ++num_pair_branchings;
+        for (int parity = 0; parity <= 1; ++parity) {
+            children[parity] = newNode(node);
+            children[parity]->xfixed[j] = LINKED;
+            children[parity]->sol.X[j] = 2 * i + parity;
+            children[parity]->branch_var = j;
+        }
+    }
+    else {
+        // Determine the variable x[ic] to branch on
+        int ic = getBranchingVariable(node);
+
+        // orbital branching: the orbit of x[ic] is fixed to 1 - v in the child without x[ic] = v
+        int orbit[BabPbSize];
+        int orbit_size = (params.symmetry) ? symmetryOrbit(node, ic, orbit) : 1;
+        int v = (node->fracsol[ic] > 0.5) ? 1 : 0;
+
+        for (int xic = 0; xic <= 1; ++xic) { 
+
+            // Create a new child node from the parent node
+            children[xic] = newNode(node);
+
+            // split on node ic
+            children[xic]->xfixed[ic] = 1;
+            children[xic]->sol.X[ic] = xic;
+            children[xic]->branch_var = ic;
+
+            if (xic != v) {
+                for (int k = 1; k < orbit_size; ++k) {
+                    children[xic]->xfixed[orbit[k]] = 1;
+                    children[xic]->sol.X[orbit[k]] = xic;
+                }
+            }
+        }
+    }
+
+    children[0]->id = Trace_NextId();
+    children[1]->id = Trace_NextId();
+}
+
+
 /* Count the number of fixed variables */
 int countFixedVariables(BabNode *node) {
     
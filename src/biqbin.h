@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <mpi.h>
+#include <pthread.h>
 
 #include "biqbin_cpp_api.h"
 #include "blas_laplack.h"
@@ -14,7 +15,8 @@ typedef enum Message
 {
     SEND_FREEWORKERS, // send ranks of free workers
     IDLE,             // worker is free, his local queue of subproblems is empty
-    NEW_VALUE         // better lower bound found
+    NEW_VALUE,        // better lower bound found
+    SYNC_STATS        // exchange shared search statistics
 } Message;
 
 // TAGS in MPI messages
@@ -26,24 +28,74 @@ typedef enum Tags
     NUM_FREE_WORKERS,
     PROBLEM,
     LOWER_BOUND, // new lower bound
-    SOLUTION     // solution vector
+    SOLUTION,    // solution vector
+    STATS        // shared search statistics
 } Tags;
 
 /************************************************************************************************************/
 
 #define BIG_NUMBER 1e+9
 
+/* Tolerance when objective coefficients and bounds are compared with the objective lattice (granularity) */
+#define LATTICE_EPS 1e-6
+
 /* Maximum number of cutting planes (triangle, pentagonal and heptagonal inequalities) allowed to add */
 #define MaxTriIneqAdded 50000
 #define MaxPentIneqAdded 50000
 #define MaxHeptaIneqAdded 50000
 
+/* Duality gap of the basic SDP relaxation if the node is branched anyway (params.ipm_early_stop) */
+#define IPM_BRANCH_GAP 1.0
+
+/* Workspace of ipm_mc_pk_work: matrices Z, dX, dX1, tmp, tmp2, Zi, M and vectors y, b, dy, dy1 */
+#define IPM_WORK_MATRICES 7
+#define IPM_WORK_VECTORS 4
+#define IPM_WORKSPACE_SIZE(n) (IPM_WORK_MATRICES * (n) * (n) + IPM_WORK_VECTORS * (n))
+
+/* Number of problems solved together by ipm_mc_pk_batch (params.ipm_batch) */
+#define IPM_BATCH 8
+
+/* Largest subproblem size solved in batches, larger ones use ipm_mc_pk_work */
+#define IPM_BATCH_MAX_N 12
+
+/* Number of additional heuristic runs per node in dive mode (close to time limit) */
+#define DIVE_HEURISTIC_RUNS 5
+
+/* Trace of the B&B tree (params.trace) */
+#define TRACE_MAGIC "BBTRACE"
+#define TRACE_VERSION 1
+#define TRACE_BUFFER_SIZE 4096  // records buffered before writing to file
+
+/* Outcome of an evaluated node in the trace */
+#define TRACE_PRUNED 0          // bound below incumbent + 1
+#define TRACE_BRANCHED 1        // branched after cutting plane iterations
+#define TRACE_GIVEUP 2          // branched early: cutting planes not expected to close the gap
+
 /* Maximum size of bundle */
 #define MaxBundle 400
 
 /* Branching strategies */
 #define LEAST_FRACTIONAL 0
 #define MOST_FRACTIONAL 1
+#define STRONG_BRANCHING 2
+#define PSEUDO_COST 3
+#define LEARNED_SCORE 4
+
+/* Families of cutting planes (cut_control.c) */
+#define CUT_TRIANGLE 0
+#define CUT_PENTAGONAL 1
+#define CUT_HEPTAGONAL 2
+
+/* Value of xfixed[i] if x[i] is linked to another variable by pair branching */
+#define LINKED 2
+
+/* Score of a strong branching candidate from the bound decreases of its children */
+#define SB_SCORE_PRODUCT 0
+#define SB_SCORE_MIN 1
+
+/* Which nodes are sent to free workers */
+#define DONATE_BEST_BOUND 0       // nodes with the largest upper bound
+#define DONATE_LARGEST_SUBTREE 1  // nodes with the largest estimated subtree
 
 // BiqBin parameters and default values
 #ifndef PARAM_FIELDS
@@ -67,7 +119,36 @@ typedef enum Tags
     P(int, root, "%d", 0)                    \
     P(int, use_diff, "%d", 1)                \
     P(int, time_limit, "%d", 0)              \
-    P(int, branchingStrategy, "%d", MOST_FRACTIONAL)
+    P(int, dive_time, "%d", 0)               \
+    P(int, branchingStrategy, "%d", MOST_FRACTIONAL) \
+    P(int, sb_candidates, "%d", 8)           \
+    P(int, sb_bundle_iter, "%d", 2)          \
+    P(int, sb_threads, "%d", 1)              \
+    P(int, sb_score, "%d", SB_SCORE_PRODUCT) \
+    P(int, pc_reliability, "%d", 4)          \
+    P(int, stats_sync_interval, "%d", 10)    \
+    P(int, pair_branching, "%d", 0)          \
+    P(double, pair_threshold, "%lf", 0.7)    \
+    P(int, dual_fixing, "%d", 0)             \
+    P(int, root_probing, "%d", 0)            \
+    P(int, cut_cache, "%d", 0)               \
+    P(int, child_prebound, "%d", 0)          \
+    P(int, enum_threshold, "%d", 0)          \
+    P(int, enum_threads, "%d", 1)            \
+    P(int, components, "%d", 0)              \
+    P(int, symmetry, "%d", 0)                \
+    P(int, incremental_subproblem, "%d", 4)  \
+    P(double, sparse_density, "%lf", 0.0)    \
+    P(int, spectral_iter, "%d", 0)           \
+    P(int, ipm_early_stop, "%d", 0)          \
+    P(int, ipm_batch, "%d", 1)               \
+    P(int, cut_control, "%d", 0)             \
+    P(int, adaptive_diff, "%d", 0)           \
+    P(int, pipeline, "%d", 0)                \
+    P(int, node_selection, "%d", 0)          \
+    P(int, donation_strategy, "%d", DONATE_BEST_BOUND) \
+    P(double, min_donation_size, "%lf", 3.0) \
+    P(int, trace, "%d", 0)
 #endif
 
 typedef struct BiqBinParameters
@@ -106,6 +187,74 @@ typedef struct Heptagonal_Inequality
     double y;     // corresponding dual multiplier
 } Heptagonal_Inequality;
 
+/* Time spent in the phases of SDPbound for the last evaluated node */
+typedef struct EvalStats
+{
+    double time_ipm;        // basic SDP relaxation
+    double time_bundle;     // bundle method (incl. bundle update)
+    double time_heuristic;  // runHeuristic
+    double time_separation; // separation of triangle, pentagonal and heptagonal inequalities
+    int gave_up;            // 1 if cutting planes were stopped early (TRACE_GIVEUP)
+    int num_tri;            // number of cuts at exit
+    int num_pent;
+    int num_hepta;
+} EvalStats;
+
+/* Header of a trace file */
+typedef struct TraceHeader
+{
+    char magic[8];          // TRACE_MAGIC
+    int version;            // TRACE_VERSION
+    int record_size;        // sizeof(TraceRecord)
+    int rank;
+    int num_vars;           // BabPbSize
+} TraceHeader;
+
+/* One evaluated node in a trace file (layout read by read_trace.py) */
+typedef struct TraceRecord
+{
+    long long id;
+    long long parent_id;
+    double parent_bound;    // bound inherited from the parent
+    double bound;           // computed upper bound
+    double incumbent;       // best lower bound after evaluation
+    double t_start;         // start of evaluation (seconds since start)
+    double t_total;         // wall time of evaluation
+    double t_ipm;
+    double t_bundle;
+    double t_heuristic;
+    double t_separation;
+    int rank;               // rank that evaluated the node
+    int depth;
+    int branch_var;
+    int outcome;            // TRACE_PRUNED, TRACE_BRANCHED, TRACE_GIVEUP
+    int num_tri;            // number of cuts at exit
+    int num_pent;
+    int num_hepta;
+    int unused;             // padding
+} TraceRecord;
+
+/* Cutting planes of a node with original variable indices (cut_pool.c) */
+typedef struct CutPool
+{
+    int NIneq;
+    int NPentIneq;
+    int NHeptaIneq;
+    Triangle_Inequality *Cuts;
+    Pentagonal_Inequality *Pent_Cuts;
+    Heptagonal_Inequality *Hepta_Cuts;
+} CutPool;
+
+/* Symmetric matrix: dense diagonal and off-diagonal nonzeros in compressed sparse row format (sparse.c) */
+typedef struct SparseMatrix
+{
+    int n;
+    int *row_start; // entries of row i: row_start[i], ..., row_start[i + 1] - 1
+    int *col;
+    double *val;
+    double *diag;
+} SparseMatrix;
+
 /* heap (data structure) declaration */
 typedef struct Heap
 {
@@ -114,6 +263,21 @@ typedef struct Heap
     BabNode **data; /* array of BabNodes                  */
 } Heap;
 
+/* one heap of the relaxed concurrent priority queue, padded to its own cache line */
+typedef struct SubQueue
+{
+    pthread_mutex_t lock; /* protects heap                              */
+    double top;           /* priority of heap top, -BIG_NUMBER if empty */
+    Heap *heap;
+} __attribute__((aligned(64))) SubQueue;
+
+/* MultiQueue: relaxed priority queue for several threads on one rank */
+typedef struct MultiQueue
+{
+    int num_queues;    /* number of heaps (c * number of threads) */
+    SubQueue *queues;
+} MultiQueue;
+
 /**** Declarations of functions per file ****/
 
 /* allocate_free.c */
@@ -131,16 +295,23 @@ void printSolution(FILE *file);
 void printFinalOutput(FILE *file, int num_nodes);
 void Bab_End(void);
 int getBranchingVariable(BabNode *node);
+void createChildren(BabNode *node, BabNode *children[2]);
 int countFixedVariables(BabNode *node);
+void computeGranularity(int rank);
+double latticeFloor(double bound);              // round upper bound down to the objective lattice
+int timeLimitReached(void);
+int diveModeActive(void);
 
 /* bounding.c */
 double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank);
+double childPreBound(BabNode *child, const CutPool *pool, Problem *SP, Problem *PP);
 
 /* bundle.c */
 double fct_eval(const Problem *PP, double *dual_gamma, double *X, double *g);
 void solve_lambda(int k, double *Q, double *c, double *lambda);
 void lambda_eta(const Problem *PP, double *zeta, double *G, double *dual_gamma, double *dgamma, double *lambda, double *eta, double *t);
 void bundle_method(Problem *PP, double *t, int bdl_iter);
+void bundle_init(Problem *PP, int evaluate);
 
 /* cutting_planec.c */
 double evaluateTriangleInequality(double *XX, int N, int type, int ii, int jj, int kk);
@@ -150,11 +321,23 @@ double getViolated_PentagonalInequalities(double *X, int N, Pentagonal_Inequalit
 double updatePentagonalInequalities(Problem *PP, double *y, int *NumAdded, int *NumSubtracted, int triag);
 double getViolated_HeptagonalInequalities(double *X, int N, Heptagonal_Inequality *Hepta_List, int *ListSize);
 double updateHeptagonalInequalities(Problem *PP, double *y, int *NumAdded, int *NumSubtracted, int hept_index);
+void setSeparationEffort(int family, double effort);   // fraction of cuts and trials per round, family CUT_*
+
+/* components.c */
+int findComponents(const Problem *PP, int *component);
+double evaluateComponents(BabNode *node, Problem *SP, Problem *PP, int rank, const int *component, int num_components);
+
+/* dual_fixing.c */
+int dualFixing(BabNode *node, int max_candidates);
 
 /* evaluate.c */
 double Evaluate(BabNode *node, Problem *SP, Problem *PP, int rank);
 void createSubproblem(BabNode *node, Problem *SP, Problem *PP);
 double getFixedValue(BabNode *node, Problem *SP);
+void freeSubproblemCache(void);
+int hasLinkedVariables(const BabNode *node);
+int resolveVariable(const int *xfixed, const int *sol_X, int i, int *parity);
+void resolveLinkedVariables(const int *xfixed, const int *sol_X, int *x);
 
 /* heap.c */
 void Bab_incEvalNodes(void);                         // increment the number of evaluated nodes
@@ -162,18 +345,42 @@ int isPQEmpty(void);                                 // checks if queue is empty
 int Bab_LBUpd(double new_lb, BabSolution *bs);       // checks and updates lower bound if better found, returns 1 if success
 BabNode *newNode(BabNode *parentNode);               // create child node from parent
 BabNode *Bab_PQPop(void);                            // take and remove the node with the highest priority
-void Bab_PQInsert(BabNode *node);                    // insert node into priority queue based on intbound and level
+void Bab_PQInsert(BabNode *node);                    // insert node into priority queue based on node->priority
 void Bab_LBInit(double lowerBound, BabSolution *bs); // initialize global lower bound and solution vector
 Heap *Init_Heap(int size);                           // allocates space for heap (array of BabNode*)
+BabNode *Heap_Pop(Heap *h);                          // take and remove the node with the highest priority from h
+void Heap_Insert(Heap *h, BabNode *node);            // insert node into heap h
+void Heap_Rebuild(Heap *h);                          // restore heap property after entries were removed
+BabNode *Heap_Remove(Heap *h, int index);            // take and remove the node at position index
+int compare_Nodes(const BabNode *node1, const BabNode *node2);   // 1 if node1 has higher priority, -1 otherwise
 
 /* heuristic.c */
 double runHeuristic(Problem *P0, Problem *P, BabNode *node, int *x);
 double GW_heuristic(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X, int *x, int num); // RK
+double runHeuristicOnMatrix(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X,
+                            double *Xs, double *Zs, int *x);
 // RK double mc_1opt(int *x, Problem *P0);
 double mc_1opt(int *x, double *P_L, int P_N);
+double mc_1opt_sparse(int *x, const SparseMatrix *S);
+
+/* multiqueue.c */
+MultiQueue *MQ_Init(int num_threads, int queues_per_thread, int size);  // c = queues_per_thread heaps per thread
+void MQ_Free(MultiQueue *mq);                                          // frees queues and all remaining nodes
+void MQ_Insert(MultiQueue *mq, BabNode *node, unsigned int *seed);     // insert into a random heap
+BabNode *MQ_PopApprox(MultiQueue *mq, unsigned int *seed);             // pop best of two random heaps, NULL if empty
+int MQ_ExtractBulk(MultiQueue *mq, BabNode **nodes, int k);            // remove k globally best nodes (donations)
+int MQ_PruneBelow(MultiQueue *mq, double threshold);                   // free nodes with upper_bound < threshold
+int MQ_Size(MultiQueue *mq);                                           // number of stored nodes
 
 /* ipm_mc_pk.c */
 void ipm_mc_pk(double *L, int n, double *X, double *phi, int print);
+void ipm_mc_pk_bounded(double *L, int n, double *X, double *phi, int print, double prune_below, double branch_above);
+void ipm_mc_pk_work(double *L, int n, double *X, double *phi, int print, double prune_below, double branch_above,
+                    double *work);
+void freeIPMWorkspace(void);
+
+/* ipm_batch.c */
+void ipm_mc_pk_batch(double *const *L, double *const *X, double *phi, int count, int n, double prune_below);
 
 /* operators.c */
 void diag(const double *X, double *y, int n);
@@ -187,6 +394,91 @@ int processCommandLineArguments(int argc, char **argv, int rank);
 int readParameters(const char *path, int rank);
 
 
+/* subtree_estimate.c */
+void recordBoundDrop(int level, double parent_bound, double bound);
+void recordNodeOutcome(int branched);
+double estimateSubtreeSize(BabNode *node);          // log2 of the expected number of nodes in subtree
+
+/* pipeline.c */
+void initPipeline(void);
+void freePipeline(void);
+int Pipeline_StartHeuristic(Problem *SP, Problem *PP, BabNode *node);   // 0 if not pipelined
+int Pipeline_FinishHeuristic(void);                 // merge running heuristic, 0 if none
+
+/* adaptive_diff.c */
+void initAdaptiveDiff(void);
+void recordCutImprovement(BabNode *node, double basic_bound, double bound);
+double expectedCutImprovement(BabNode *node);          // replaces diff in the use_diff test
+
+/* cut_control.c */
+void initCutControl(void);
+void CutControl_Node(const BabNode *node, int *use_pent, int *use_hepta);
+void CutControl_Round(int level, const double *mass, const double *sep_time, double bundle_time, double gain);
+
+/* cut_pool.c */
+CutPool *saveCuts(const BabNode *node, const Problem *P, const double *gamma);
+int loadCuts(const CutPool *pool, const BabNode *node, Problem *P, double *gamma);
+void freeCutPool(CutPool *pool);
+void CutCache_Store(const BabNode *node, const Problem *P, const double *gamma, double t);
+int CutCache_Load(const BabNode *node, Problem *P, double *gamma, double *t);
+void CutCache_Free(void);
+
+/* spectral.c */
+int spectralBound(const Problem *PP, double threshold, double *bound);
+
+/* strong_branching.c */
+int selectFractionalCandidates(BabNode *node, const int *eligible, int num_eligible, int max_candidates, int *candidates);
+int selectIntegralCandidates(BabNode *node, int max_candidates, int *candidates);
+void strongBranchingProbe(BabNode *node, const int *candidates, int num_candidates, double *bounds);
+int strongBranchingVariable(BabNode *node);
+
+/* enumeration.c */
+double enumerateSubproblem(BabNode *node, Problem *PP);
+
+/* pseudocost.c */
+void initPseudoCosts(void);
+void recordPseudoCost(int var, int value, double parent_bound, double bound);
+void recordNodePseudoCost(BabNode *node, double parent_bound);
+int pseudoCostBranchingVariable(BabNode *node);
+void pseudoCostEstimates(int var, double est[2], double *count);   // count: observations of the less observed side
+
+/* scorer.c */
+int loadScorer(const char *param_path, int rank);
+void Scorer_StoreColumnStats(const BabNode *node);
+int learnedBranchingVariable(BabNode *node);
+void setNodePriority(BabNode *node);
+
+/* root_probing.c */
+int rootProbing(BabNode *root, int rank, MPI_Datatype BabNodetype);
+
+/* symmetry.c */
+void initSymmetry(int rank);
+int symmetryOrbit(BabNode *node, int ic, int *orbit);
+void freeSymmetry(void);
+
+/* sparse.c */
+SparseMatrix *sparseFromDense(const double *A, int n, int m);   // off-diagonal nonzeros of the upper left m x m block
+void freeSparseMatrix(SparseMatrix *S);
+void initSparse(int rank);
+const SparseMatrix *sparseLaplacian(void);                      // NULL if the dense routines are used
+void freeSparse(void);
+
+/* shared_stats.c */
+#define SHARED_STATS_DEPTH_RANGES 4                 // depth ranges of SharedStats_DepthRange: 0-1, 2-3, 4-7, >= 8
+int SharedStats_Register(int size);                 // register block of statistics, returns offset
+int SharedStats_DepthRange(int level);              // depth range of a node at level
+const double *SharedStats_Get(int offset);
+void SharedStats_Add(int index, double value);
+void SharedStats_NodeDone(void);                    // worker: synchronize with master if due
+void SharedStats_MasterSync(int source);            // master: answer SYNC_STATS of source
+void SharedStats_Free(void);
+
+/* trace.c */
+long long Trace_NextId(void);                       // unique node id
+void Trace_Open(const char *instance, int rank);
+void Trace_Node(BabNode *node, double parent_bound, double t_start, int outcome);
+void Trace_Close(void);
+
 /* qap_simuted_annealing.c */
 double qap_simulated_annealing(int *H, int k, double *X, int n, int *pent);
 
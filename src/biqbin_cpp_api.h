@@ -53,13 +53,19 @@ typedef struct BabSolution
  */
 typedef struct BabNode
 {
-    int xfixed[NMAX];     // 0-1 vector specifying which nodes are fixed
-    BabSolution sol;      // 0-1 solution vector
+    int xfixed[NMAX];     // 0-1 vector specifying which nodes are fixed, LINKED (2) for pair branching
+    BabSolution sol;      // 0-1 solution vector, for LINKED i: sol.X[i] = 2*j + p means x[i] = x[j] XOR p
     double fracsol[NMAX]; // fractional vector obtained from primal matrix X (last column except last element)
                           // from bounding routine. Used for determining the next branching variable.
     int level;            // level (depth) of the node in B&B tree
     double upper_bound;   // upper bound on solution value of max-cut, i.e. MC <= upper_bound.
                           // Used for determining the next node in priority queue.
+    double prebound;      // bound known before the node is evaluated: bound of the parent or
+                          // pre-bound of the child (params.child_prebound), at most upper_bound
+    long long id;         // unique id of the node (rank of creating process in upper bits)
+    long long parent_id;  // id of the parent node, -1 for root
+    int branch_var;       // variable fixed when this node was created, -1 for root
+    double priority;      // key of the priority queue (compare_Nodes), set by setNodePriority before insertion
 } BabNode;
 
 EXTERN_C double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X, int *x);
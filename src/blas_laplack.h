@@ -37,6 +37,9 @@ extern void dsysv_(char *uplo, int *n, int *nrhs, double *A, int *lda, int *ipiv
 
 // computes solution to a real system of linear equations with positive definite matrix
 extern void dposv_(char *uplo, int *n, int *nrhs, double *A, int *lda, double *B, int *ldb, int *info);
+
+// computes all eigenvalues and eigenvectors of a real symmetric tridiagonal matrix
+extern void dstev_(char *jobz, int *n, double *d, double *e, double *z, int *ldz, double *work, int *info);
 #ifdef __cplusplus
 }
 #endif
@@ -19,11 +19,97 @@ extern double *dual_gamma;                        // dual multiplers for triangl
 extern double *X_test;
 
 extern double diff;		                     // difference between basic SDP relaxation and bound with added cutting planes
+extern double bound_offset;                  // bound of the other components (components.c)
+extern double prune_threshold;               // early termination of the IPM (params.ipm_early_stop)
+extern double granularity;                  // objective values are multiples, a node is pruned if bound < LB + granularity
+extern EvalStats eval_stats;                 // phase times of this node (trace)
+
+/* Store the fractional solution (last column of X) of the subproblem in the node */
+static void storeFractionalSolution(BabNode *node, const Problem *PP) {
+
+    int index = 0;
+    int parity;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (node->xfixed[i] == 1) {
+            node->fracsol[i] = (double) node->sol.X[i];
+        }
+        else if (!node->xfixed[i]) {
+            // convert x (last column X) from {-1,1} to {0,1}
+            node->fracsol[i] = 0.5*(X[(PP->n - 1) + index*PP->n] + 1.0); 
+            ++index;
+        }
+    }
+
+    // linked variables (pair branching) from their representatives
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (node->xfixed[i] == LINKED) {
+            int r = resolveVariable(node->xfixed, node->sol.X, i, &parity);
+            node->fracsol[i] = (parity) ? 1.0 - node->fracsol[r] : node->fracsol[r];
+        }
+    }
+}
+
+
+/*
+ * Start the bundle method from the cuts and multipliers of the parent of node
+ * if its process still has them (cut_pool.c). f and X are the basic SDP
+ * relaxation on entry. The dual function at the multipliers of the parent is
+ * used if it is better than the basic bound, otherwise the bundle starts at
+ * zero multipliers with the cuts of the parent.
+ * Returns 1 if the bundle was initialized, t is the penalty parameter of the parent.
+ */
+static int warmStart(BabNode *node, Problem *PP, double *t) {
+
+    if (params.cut_cache <= 0)
+        return 0;
+
+    int m = CutCache_Load(node, PP, dual_gamma, t);
+    if (m == 0)
+        return 0;
+
+    int nn = PP->n * PP->n;
+    int inc = 1;
+    double f_basic = f;
+    double t_phase = MPI_Wtime();
+
+    double *X_basic;
+    alloc_matrix(X_basic, PP->n, double);
+    dcopy_(&nn, X, &inc, X_basic, &inc);
+
+    // dual function at the multipliers of the parent
+    bundle_init(PP, 1);
+
+    if (f > f_basic) {
+        f = f_basic;
+        dcopy_(&nn, X_basic, &inc, X, &inc);
+        for (int i = 0; i < m; ++i)
+            dual_gamma[i] = 0.0;
+        bundle_init(PP, 0);
+    }
+
+    free(X_basic);
+    eval_stats.time_bundle += MPI_Wtime() - t_phase;
+
+    return 1;
+}
+
+
+/* lower bound for the bound f + fixedvalue of the evaluated node (without the other components) */
+static double nodeLowerBound(void) {
+    return Bab_LBGet() - bound_offset;
+}
+
+
+/* IPMs of the node stop as soon as f proves pruning (params.ipm_early_stop) */
+static void setPruneThreshold(double fixedvalue) {
+    prune_threshold = (params.ipm_early_stop) ? nodeLowerBound() + granularity - fixedvalue : -BIG_NUMBER;
+}
+
 
 /******** main bounding routine calling bundle method ********/
 double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
 
-    int index;                      // helps to store the fractional solution in the node
     double bound;                   // f + fixedvalue
     double gap;                     // difference between best lower bound and upper bound
     double oldf;                    // stores f from previous iteration 
@@ -47,6 +133,12 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
     int giveup = 0;                                   
     int prune = 0;
 
+    // cutting plane families of this node, times of the last separation round (params.cut_control)
+    int use_pent = params.include_Pent;
+    int use_hepta = params.include_Hepta;
+    double round_time[3] = { 0.0, 0.0, 0.0 };
+    double round_bundle_time = 0.0;
+
     // number of initial iterations of bundle method
     int bdl_iter = params.init_bundle_iter;      
 
@@ -68,30 +160,49 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
     PP->NHeptaIneq = 0;
     int Hepta_NumAdded = 0;
     int Hepta_NumSubtracted = 0;                         
-    double t;
+    double t = 0.0;
+    double t_phase;                 // start time of current phase (eval_stats)
+
+    eval_stats.time_ipm = 0.0;
+    eval_stats.time_bundle = 0.0;
+    eval_stats.time_heuristic = 0.0;
+    eval_stats.time_separation = 0.0;
+    eval_stats.gave_up = 0;
+
+    /* eigenvalue bound (params.spectral_iter): prune without solving the basic SDP relaxation */
+    if (params.spectral_iter > 0 && PP->n > 1) {
+        t_phase = MPI_Wtime();
+        prune = spectralBound(PP, nodeLowerBound() + granularity - fixedvalue, &f);
+        eval_stats.time_ipm += MPI_Wtime() - t_phase;
+
+        if (prune) {
+            bound = f + fixedvalue;
+            goto END;
+        }
+    }
+
     /* solve basic SDP relaxation with interior-point method */
-    ipm_mc_pk(PP->L, PP->n, X, &f, 0);
+    t_phase = MPI_Wtime();
+    setPruneThreshold(fixedvalue);
+
+    // node gives up if the basic bound is above: lower accuracy suffices
+    double improvement = expectedCutImprovement(node);
+    double branch_above = (params.ipm_early_stop && params.use_diff && rank != 0) ?
+                          nodeLowerBound() + improvement + granularity - fixedvalue : BIG_NUMBER;
+
+    ipm_mc_pk_bounded(PP->L, PP->n, X, &f, 0, prune_threshold, branch_above);
+    eval_stats.time_ipm += MPI_Wtime() - t_phase;
 
     // store basic SDP bound to compute diff in the root node
     double basic_bound = f + fixedvalue;
 
     // Store the fractional solution in the node    
-    index = 0;
-    for (int i = 0; i < BabPbSize; ++i) {
-        if (node->xfixed[i]) {
-            node->fracsol[i] = (double) node->sol.X[i];
-        }
-        else {
-            // convert x (last column X) from {-1,1} to {0,1}
-            node->fracsol[i] = 0.5*(X[(PP->n - 1) + index*PP->n] + 1.0); 
-            ++index;
-        }
-    }
+    storeFractionalSolution(node, PP);
 
     
     /* run heuristic */
     for (int i = 0; i < BabPbSize; ++i) {
-        if (node->xfixed[i]) {
+        if (node->xfixed[i] == 1) {
             x[i] = node->sol.X[i];
         }
         else {
@@ -99,68 +210,86 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
         }
     }
 
+    t_phase = MPI_Wtime();
     runHeuristic(SP, PP, node, x);
     updateSolution(x);
 
+    // close to the time limit spend the time on improving the incumbent
+    if (diveModeActive()) {
+        for (int run = 0; run < DIVE_HEURISTIC_RUNS; ++run) {
+            runHeuristic(SP, PP, node, x);
+            updateSolution(x);
+        }
+    }
+    eval_stats.time_heuristic += MPI_Wtime() - t_phase;
+    setPruneThreshold(fixedvalue);
+
     // upper bound
     bound = f + fixedvalue;
 
     // check pruning condition
-    if ( bound < Bab_LBGet() + 1.0 ) {
+    if ( bound < nodeLowerBound() + granularity ) {
         prune = 1;
         goto END;
     }
 
     // check if cutting planes need to be added     
-    if (params.use_diff && (rank != 0) && (bound > Bab_LBGet() + diff + 1.0)) {
+    if (params.use_diff && (rank != 0) && (bound > nodeLowerBound() + improvement + granularity)) {
         giveup = 1;
+        eval_stats.gave_up = 1;
         goto END;
     }
 
-    /* separate first triangle inequality */
-    viol3 = updateTriangleInequalities(PP, dual_gamma, &Tri_NumAdded, &Tri_NumSubtracted);
-
-    /***************
-     * Bundle init *
-     ***************/
-
-    // set dual_gamma = 0
-    for (int i = 0; i < PP->NIneq; ++i) {
-        dual_gamma[i] = Cuts[i].y;
+    // no time for cutting planes: dive with the basic bound or stop
+    if (diveModeActive() || timeLimitReached()) {
+        giveup = 1;
+        goto END;
     }
 
-    // t = 0.5 * (f - fh) / (PP->NIneq * viol3^2)
-    t = 0.5 * (bound - Bab_LBGet()) / (PP->NIneq * viol3 * viol3);
+    CutControl_Node(node, &use_pent, &use_hepta);
 
-    // first evaluation at dual_gamma: f = fct_eval(PP, dual_gamma, X, g)
-    // since dual_gamma = 0, this is just basic SDP relaxation
-    // --> only need to compute subgradient
-    dcopy_(&PP->NIneq, &e, &inc_e, g, &inc);
-    op_B(PP, g, X);
+    /* warm start: cuts and multipliers of the parent (params.cut_cache) */
+    if (warmStart(node, PP, &t)) {
 
+        // cuts of all types are present: skip the rounds with triangle inequalities only
+        count = params.triag_iter;
 
-    /* setup for bundle */
-    // F[0] = <L,X>
-    F[0] = 0.0;
-    for (int i = 0; i < PP->n; ++i) {
-        for (int j = i; j < PP->n; ++j) {
-            if (i == j) {
-                F[0] += PP->L[i + i*PP->n] * X[i + i*PP->n];
-            }
-            else {
-                F[0] += 2 * PP->L[j + i*PP->n] * X[j + i*PP->n];
-            }
+        bound = f + fixedvalue;
+        if ( bound < nodeLowerBound() + granularity ) {
+            prune = 1;
+            storeFractionalSolution(node, PP);
+            goto END;
         }
     }
+    else {
+
+        /* separate first triangle inequality */
+        t_phase = MPI_Wtime();
+        viol3 = updateTriangleInequalities(PP, dual_gamma, &Tri_NumAdded, &Tri_NumSubtracted);
+        eval_stats.time_separation += MPI_Wtime() - t_phase;
+        round_time[CUT_TRIANGLE] = MPI_Wtime() - t_phase;
 
-    // G = g
-    dcopy_(&PP->NIneq, g, &inc, G, &inc);
+        // no violated triangle inequality (e.g. small components): the basic bound is final
+        if (PP->NIneq == 0)
+            goto END;
 
-    // include X in X_bundle
-    dcopy_(&nn, X, &inc, X_bundle, &inc);
+        /***************
+         * Bundle init *
+         ***************/
 
-    // initialize the bundle counter
-    PP->bundle = 1;
+        // set dual_gamma = 0
+        for (int i = 0; i < PP->NIneq; ++i) {
+            dual_gamma[i] = Cuts[i].y;
+        }
+
+        // t = 0.5 * (f - fh) / (PP->NIneq * viol3^2)
+        t = 0.5 * (bound - nodeLowerBound()) / (PP->NIneq * viol3 * viol3);
+
+        // first evaluation at dual_gamma: f = fct_eval(PP, dual_gamma, X, g)
+        // since dual_gamma = 0, this is just basic SDP relaxation
+        // --> only need to compute subgradient
+        bundle_init(PP, 0);
+    }
 
 
     /*** Main loop ***/
@@ -171,19 +300,43 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
         oldf = f;
 
         // Call bundle method
+        t_phase = MPI_Wtime();
         bundle_method(PP, &t, bdl_iter);  
+        eval_stats.time_bundle += MPI_Wtime() - t_phase;
+
+        // bound decrease after the last separation round
+        if (params.cut_control) {
+            double mass[3] = { 0.0, 0.0, 0.0 };
+            for (int i = 0; i < PP->NIneq + PP->NPentIneq + PP->NHeptaIneq; ++i) {
+                int family = (i < PP->NIneq) ? CUT_TRIANGLE : (i < PP->NIneq + PP->NPentIneq) ? CUT_PENTAGONAL : CUT_HEPTAGONAL;
+                mass[family] += dual_gamma[i];
+            }
+
+            round_bundle_time += MPI_Wtime() - t_phase;
+            CutControl_Round(node->level, mass, round_time, round_bundle_time, oldf - f);
+
+            for (int family = CUT_TRIANGLE; family <= CUT_HEPTAGONAL; ++family)
+                round_time[family] = 0.0;
+            round_bundle_time = 0.0;
+        }
 
         // upper bound
         bound = f + fixedvalue;
 
         // prune test
-        prune = ( bound < Bab_LBGet() + 1.0 ) ? 1 : 0;
+        prune = ( bound < nodeLowerBound() + granularity ) ? 1 : 0;
  
         /******** heuristic ********/
-        if (!prune) {
+        // pipelined: merge the heuristic of the previous round, start the one of this round (params.pipeline)
+        if (Pipeline_FinishHeuristic()) {
+            setPruneThreshold(fixedvalue);
+            prune = ( bound < nodeLowerBound() + granularity ) ? 1 : 0;
+        }
+
+        if (!prune && !Pipeline_StartHeuristic(SP, PP, node)) {
 
             for (int i = 0; i < BabPbSize; ++i) {
-                if (node->xfixed[i]) {
+                if (node->xfixed[i] == 1) {
                     x[i] = node->sol.X[i];
                 }
                 else {
@@ -191,32 +344,39 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
                 }
             }
 
+            t_phase = MPI_Wtime();
             runHeuristic(SP, PP, node, x);
             updateSolution(x);
+            eval_stats.time_heuristic += MPI_Wtime() - t_phase;
+            setPruneThreshold(fixedvalue);
 
-            prune = ( bound < Bab_LBGet() + 1.0 ) ? 1 : 0;
+            prune = ( bound < nodeLowerBound() + granularity ) ? 1 : 0;
         }
         /***************************/
 
         // compute gap
-        gap = bound - Bab_LBGet();
+        gap = bound - nodeLowerBound();
 
         /* check if we will not be able to prune the node */
         if (count == params.triag_iter + params.pent_iter + params.hept_iter) {
-            if ( (gap - 1.0 > (oldf - f)*(params.max_outer_iter - count)))
-                giveup = 1;
+            if ( (gap - granularity > (oldf - f)*(params.max_outer_iter - count)))
+                giveup = eval_stats.gave_up = 1;
         }
 
         /* check if extra iterations can close the gap */
         if (count == params.max_outer_iter) {
-            if ( gap - 1.0 > (oldf - f)*params.extra_iter )
-                giveup = 1;
+            if ( gap - granularity > (oldf - f)*params.extra_iter )
+                giveup = eval_stats.gave_up = 1;
         }
         
         /* max number of iterations reached */
         if (count == params.max_outer_iter + params.extra_iter)
             giveup = 1; 
 
+        /* out of time: current bound is valid, stop improving it */
+        if (timeLimitReached())
+            giveup = 1;
+
 
         // purge inactive cutting planes, add new inequalities
         if (!prune && !giveup) {
@@ -225,14 +385,24 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
             penta = PP->NPentIneq;      // --> to know with which index in dual vector dual_gamma, pentagonal
                                         // and heptagonal inequalities start!
 
+            t_phase = MPI_Wtime();
             viol3 = updateTriangleInequalities(PP, dual_gamma, &Tri_NumAdded, &Tri_NumSubtracted);
+            round_time[CUT_TRIANGLE] = MPI_Wtime() - t_phase;
                       
             /* include pentagonal and heptagonal inequalities */          
-            if ( params.include_Pent && (count > params.triag_iter || viol3 < 0.2) )
+            if ( use_pent && (count > params.triag_iter || viol3 < 0.2) ) {
+                double t_family = MPI_Wtime();
                 viol5 = updatePentagonalInequalities(PP, dual_gamma, &Pent_NumAdded, &Pent_NumSubtracted, triag);  
+                round_time[CUT_PENTAGONAL] = MPI_Wtime() - t_family;
+            }
 
-            if ( params.include_Hepta && ( (count > params.triag_iter + params.pent_iter) || (viol3 < 0.2 && (1 - viol5 < 0.4)) ) )
+            if ( use_hepta && ( (count > params.triag_iter + params.pent_iter) || (viol3 < 0.2 && (1 - viol5 < 0.4)) ) ) {
+                double t_family = MPI_Wtime();
                 viol7 = updateHeptagonalInequalities(PP, dual_gamma, &Hepta_NumAdded, &Hepta_NumSubtracted, triag + penta);      
+                round_time[CUT_HEPTAGONAL] = MPI_Wtime() - t_family;
+            }
+
+            eval_stats.time_separation += MPI_Wtime() - t_phase;
         }
         else {               
             Tri_NumAdded = 0;
@@ -249,21 +419,13 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
             giveup;                        // upper bound to far away from lower bound
 
         // Store the fractional solution in the node    
-        index = 0;
-        for (int i = 0; i < BabPbSize; ++i) {
-            if (node->xfixed[i]) {
-                node->fracsol[i] = (double) node->sol.X[i];
-            }
-            else {
-                // convert x (last column X) from {-1,1} to {0,1}
-                node->fracsol[i] = 0.5*(X[(PP->n - 1) + index*PP->n] + 1.0); 
-                ++index;
-            }
-        }
+        storeFractionalSolution(node, PP);
 
         /*** bundle update: due to separation of new cutting planes ***/
         if (!done) {
 
+            t_phase = MPI_Wtime();
+
             // adjust size of dual_gamma
             for (int i = 0; i < PP->NIneq; ++i)
                 dual_gamma[i] = Cuts[i].y;
@@ -320,6 +482,9 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
             // new estimate for t
             t *= 1.05;
 
+            eval_stats.time_bundle += MPI_Wtime() - t_phase;
+            round_bundle_time = MPI_Wtime() - t_phase;
+
         }
 
         /* increase number of bundle iterations */
@@ -329,15 +494,54 @@ double SDPbound(BabNode *node, Problem *SP, Problem *PP, int rank) {
  
     } // end while loop
 
+    // solution of the pipelined heuristic of the last round
+    if (Pipeline_FinishHeuristic())
+        setPruneThreshold(fixedvalue);
+
     bound = f + fixedvalue;
+    prune = prune || ( bound < nodeLowerBound() + granularity );
 
     // compute difference between basic SDP relaxation and bound with added cutting planes
     if (rank == 0)
         diff = basic_bound - bound;
+    else
+        recordCutImprovement(node, basic_bound, bound);
 
     END:   
 
+    prune_threshold = -BIG_NUMBER;
+
+    eval_stats.num_tri = PP->NIneq;
+    eval_stats.num_pent = PP->NPentIneq;
+    eval_stats.num_hepta = PP->NHeptaIneq;
+
+    // children evaluated by this process start from the cuts of this node
+    if (!prune)
+        CutCache_Store(node, PP, dual_gamma, t);
+
     return bound;
 
 }
 
+
+
+/*
+ * One-shot upper bound of child (params.child_prebound): the dual function of
+ * the child at the multipliers of the parent on the cuts in pool. By weak
+ * duality this is a valid bound for any nonnegative multipliers, it costs one
+ * solve of the basic SDP relaxation. Overwrites PP, the cuts, dual_gamma, X and g.
+ */
+double childPreBound(BabNode *child, const CutPool *pool, Problem *SP, Problem *PP) {
+
+    createSubproblem(child, SP, PP);
+    loadCuts(pool, child, PP, dual_gamma);
+
+    double fixedvalue = getFixedValue(child, SP);
+
+    // the pre-bound is only compared with the lower bound
+    setPruneThreshold(fixedvalue);
+    double bound = fct_eval(PP, dual_gamma, X, g) + fixedvalue;
+    prune_threshold = -BIG_NUMBER;
+
+    return bound;
+}
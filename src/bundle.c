@@ -20,6 +20,7 @@ void bundle_method(Problem *PP, double *t, int bdl_iter) {
     extern double *gamma_test;      
     extern double *lambda;          // contains scalars of convex combinations of bundle matrices
     extern double *eta;             // dual variable to dual_gamma >= 0 constraint 
+    extern double prune_threshold;  // node is pruned if f is below
 
     // number of cutting planes
     int m = PP->NIneq + PP->NPentIneq + PP->NHeptaIneq; 
@@ -44,7 +45,7 @@ void bundle_method(Problem *PP, double *t, int bdl_iter) {
 
 
     /***** main loop *****/
-    while ( bdl_cnt < bdl_iter ) {
+    while ( bdl_cnt < bdl_iter && !timeLimitReached() ) {
 
         // increase iteration count
         ++bdl_cnt;
@@ -72,6 +73,14 @@ void bundle_method(Problem *PP, double *t, int bdl_iter) {
         /*** evaluate function at gamma_test ***/
         f_test = fct_eval(PP, gamma_test, X_test, g);
 
+        // node is pruned at gamma_test (params.ipm_early_stop)
+        if (f_test < prune_threshold) {
+            f = f_test;
+            dcopy_(&m, gamma_test, &inc, dual_gamma, &inc);
+            dcopy_(&nn, X_test, &inc, X, &inc);
+            break;
+        }
+
         /* del = f - f_appr(gamma_test) = f - (F'lambda + gamma_test'*G*lambda) */
         dcopy_(&k, F, &inc, zeta, &inc); // copy F into zeta
 
@@ -238,25 +247,85 @@ void bundle_method(Problem *PP, double *t, int bdl_iter) {
 
 }
 
+/*** initialize bundle with one element at current dual_gamma ***/
+/* evaluate = 0: X is the solution of the basic SDP relaxation (dual_gamma = 0),
+ *               only the subgradient g is computed.
+ * evaluate = 1: f, X and g are computed with fct_eval at dual_gamma
+ *               (warm start with multipliers of cuts from another node).
+ */
+void bundle_init(Problem *PP, int evaluate) {
+
+    extern double f;
+    extern double *g;
+    extern double *X;
+    extern double *X_bundle;
+    extern double *F;
+    extern double *G;
+    extern double *dual_gamma;
+
+    int m = PP->NIneq + PP->NPentIneq + PP->NHeptaIneq;
+    int nn = PP->n * PP->n;
+    int inc = 1;
+    int inc_e = 0;
+    double e = 1.0;
+
+    if (evaluate) {
+        f = fct_eval(PP, dual_gamma, X, g);
+    }
+    else {
+        dcopy_(&m, &e, &inc_e, g, &inc);
+        op_B(PP, g, X);
+    }
+
+    // F[0] = <L,X>
+    F[0] = 0.0;
+    for (int i = 0; i < PP->n; ++i) {
+        for (int j = i; j < PP->n; ++j) {
+            if (i == j) {
+                F[0] += PP->L[i + i*PP->n] * X[i + i*PP->n];
+            }
+            else {
+                F[0] += 2 * PP->L[j + i*PP->n] * X[j + i*PP->n];
+            }
+        }
+    }
+
+    // G = g
+    dcopy_(&m, g, &inc, G, &inc);
+
+    // include X in X_bundle
+    dcopy_(&nn, X, &inc, X_bundle, &inc);
+
+    // initialize the bundle counter
+    PP->bundle = 1;
+}
+
+
 /*** evaluate dual function: compute its value f and subgradient g ***/
 double fct_eval(const Problem *PP, double *dual_gamma, double *X, double *g) {
 
+    extern double prune_threshold;
+    extern double *L_eval;
+
     int n = PP->n;
     int m = PP->NIneq + PP->NPentIneq + PP->NHeptaIneq;
     int nn = n * n;
     int inc = 1;
     double f;   // function value
  
-    /* L0 = L - A^T(dual_gamma) */
-    double *L0;
-    alloc_matrix(L0, n, double);
+    /* L0 = L - A^T(dual_gamma), L_eval and the IPM workspace are shared: main thread only */
+    double *L0 = L_eval;
     dcopy_(&nn, PP->L, &inc, L0, &inc);
 
     if (m > 0)
         op_Bt(PP, L0, dual_gamma);
 
-    /* solve basic SDP relaxation */
-    ipm_mc_pk(L0, n, X, &f, 0);
+    /* solve basic SDP relaxation, stop if the dual function proves pruning */
+    double sum_gamma = 0.0;
+    for (int i = 0; i < m; ++i)
+        sum_gamma += dual_gamma[i];
+
+    ipm_mc_pk_bounded(L0, n, X, &f, 0, prune_threshold - sum_gamma, BIG_NUMBER);
 
     if (m > 0) {
         /* compute function value f: add sum(dual_gamma) 
@@ -269,8 +338,6 @@ double fct_eval(const Problem *PP, double *dual_gamma, double *X, double *g) {
         op_B(PP, g, X);
     }
 
-    free(L0);
-
     return f;
 }
 
@@ -0,0 +1,243 @@
+/* Decomposition of subproblems into connected components (params.components) */
+
+/*
+ * Free variables i, j of a subproblem are adjacent if PP->L[i][j] != 0 (the
+ * last row, i.e. the linear part, is not used). If the free variables split
+ * into components C_1, ..., C_k, the objective of the node is
+ *   v(x) = g_1(x_C1) + ... + g_k(x_Ck) + constant,
+ * so max v = sum max g_c + constant and every component can be bounded on
+ * its own (with cuts on the small component only, or by enumeration if the
+ * component is small enough).
+ *
+ * Component c is evaluated as the node in which the free variables outside
+ * C_c are fixed to a reference solution z: its bound U_c is an upper bound
+ * of max g_c + v(z) - g_c(z_Cc), and the bound of the node is
+ *   v(z0) + sum_c (U_c - v(z))
+ * with z0 = 0 on the free variables (U_c - v(z) only depends on z on C_c).
+ * Components that were evaluated are set to their best solution in z, so
+ * that the heuristic of the next component finds solutions of the whole node.
+ * Before the components are evaluated, U_c is the basic SDP bound of the
+ * component. While component c is evaluated, the current bounds of the other
+ * components are added to its bound (bound_offset) when it is compared with
+ * the lower bound, so that pruning and giving up refer to the whole node.
+ * Evaluation stops as soon as the node can be pruned.
+ *
+ * For branching, X of the node is assembled from the components: entries
+ * between two components are products of their entries in the last row.
+ */
+
+#include <string.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern EvalStats eval_stats;
+extern double diff;
+extern double *X;
+extern BabSolution *BabSol;
+extern double bound_offset;
+extern double granularity;
+
+
+/*
+ * component[i] = component of free variable i = 0, ..., PP->n - 2 of the
+ * subproblem, returns the number of components.
+ */
+int findComponents(const Problem *PP, int *component) {
+
+    int n = PP->n - 1;
+    int stack[n];
+    int num_components = 0;
+
+    for (int i = 0; i < n; ++i)
+        component[i] = -1;
+
+    /* depth first search */
+    for (int r = 0; r < n; ++r) {
+
+        if (component[r] >= 0)
+            continue;
+
+        int top = 0;
+        stack[top++] = r;
+        component[r] = num_components;
+
+        while (top > 0) {
+            int i = stack[--top];
+            for (int j = 0; j < n; ++j) {
+                if (component[j] < 0 && PP->L[j + i*PP->n] != 0.0) {
+                    component[j] = num_components;
+                    stack[top++] = j;
+                }
+            }
+        }
+
+        ++num_components;
+    }
+
+    return num_components;
+}
+
+
+/* node in which the free variables outside component c are fixed to z */
+static void componentNode(const BabNode *node, int c, const int *component, const int *free_var, int num_free,
+                          const int *z, BabNode *part) {
+
+    *part = *node;
+    for (int s = 0; s < num_free; ++s) {
+        if (component[s] != c) {
+            part->xfixed[free_var[s]] = 1;
+            part->sol.X[free_var[s]] = z[free_var[s]];
+        }
+    }
+}
+
+
+/*
+ * Bound node by evaluating each of the num_components components of its
+ * subproblem PP separately. The fractional solution of node is combined from
+ * the components.
+ */
+double evaluateComponents(BabNode *node, Problem *SP, Problem *PP, int rank, const int *component, int num_components) {
+
+    /* free variables of node (subproblem index -> variable) */
+    int free_var[BabPbSize];
+    int num_free = 0;
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (!node->xfixed[i])
+            free_var[num_free++] = i;
+    }
+
+    /* reference solution z: free variables are 0, evaluated components get their best solution */
+    int z[BabPbSize];
+    for (int i = 0; i < BabPbSize; ++i)
+        z[i] = (node->xfixed[i]) ? node->sol.X[i] : 0;
+    resolveLinkedVariables(node->xfixed, node->sol.X, z);
+    double value_z = evaluateSolution(z);
+
+    BabNode *part;
+    alloc(part, BabNode);
+
+    /* excess[c] = U_c - v(z), basic SDP bounds until component c is evaluated */
+    double excess[num_components];
+    double total = 0.0;
+    double phi;
+
+    for (int c = 0; c < num_components; ++c) {
+        componentNode(node, c, component, free_var, num_free, z, part);
+        createSubproblem(part, SP, PP);
+        ipm_mc_pk(PP->L, PP->n, X, &phi, 0);
+        excess[c] = phi + getFixedValue(part, SP) - value_z;
+        total += excess[c];
+    }
+
+    /* X of the node, last vertex l */
+    int n = BabPbSize + 1 - countFixedVariables(node);
+    int l = n - 1;
+    double *Xn;
+    alloc_matrix(Xn, n, double);
+
+    double diff_sum = 0.0;
+    EvalStats stats;
+    memset(&stats, 0, sizeof(EvalStats));
+
+    int c;
+    for (c = 0; c < num_components && value_z + total >= Bab_LBGet() + granularity; ++c) {
+
+        componentNode(node, c, component, free_var, num_free, z, part);
+
+        // enumerated components do not set diff
+        if (rank == 0)
+            diff = 0.0;
+
+        // U_c - v(z) does not depend on z outside of component c
+        double value_cur = evaluateSolution(z);
+        double LB_before = Bab_LBGet();
+
+        // prune and give up with the bounds of the other components:
+        // bound of node = bound_part - value_cur + value_z + total - excess[c]
+        bound_offset = total - excess[c] + value_z - value_cur;
+
+        // subproblem of a component is connected, Evaluate does not decompose it again
+        double bound_part = Evaluate(part, SP, PP, rank);
+
+        bound_offset = 0.0;
+
+        // keep the basic bound if the evaluation stopped above it
+        if (bound_part - value_cur < excess[c]) {
+            total -= excess[c] - (bound_part - value_cur);
+            excess[c] = bound_part - value_cur;
+        }
+
+        /* members of the component in the order of the subproblem of part */
+        int member[num_free + 1];
+        int size = 0;
+        for (int s = 0; s < num_free; ++s) {
+            if (component[s] == c) {
+                int i = free_var[s];
+                node->fracsol[i] = part->fracsol[i];
+                member[size++] = s;
+
+                // best solution of the component: heuristic if it was improved, otherwise rounded
+                z[i] = (Bab_LBGet() > LB_before) ? BabSol->X[i] : (part->fracsol[i] > 0.5);
+            }
+        }
+        member[size] = l;
+        resolveLinkedVariables(node->xfixed, node->sol.X, z);
+
+        // small components are enumerated: X = yy' of the optimal solution
+        int enumerated = (PP->n - 1 < params.enum_threshold);
+        for (int p = 0; p <= size; ++p) {
+            for (int q = 0; q <= size; ++q) {
+                double y_p = (p < size) ? 2.0 * part->fracsol[free_var[member[p]]] - 1.0 : 1.0;
+                double y_q = (q < size) ? 2.0 * part->fracsol[free_var[member[q]]] - 1.0 : 1.0;
+                Xn[member[q] + member[p]*n] = (enumerated) ? y_p * y_q : X[q + p*PP->n];
+            }
+        }
+
+        if (rank == 0)
+            diff_sum += diff;
+
+        stats.time_ipm += eval_stats.time_ipm;
+        stats.time_bundle += eval_stats.time_bundle;
+        stats.time_heuristic += eval_stats.time_heuristic;
+        stats.time_separation += eval_stats.time_separation;
+        stats.gave_up |= eval_stats.gave_up;
+        stats.num_tri += eval_stats.num_tri;
+        stats.num_pent += eval_stats.num_pent;
+        stats.num_hepta += eval_stats.num_hepta;
+    }
+
+    free(part);
+
+    if (rank == 0)
+        diff = diff_sum;
+    eval_stats = stats;
+
+    // PP of node for branching, cuts of the components are not used
+    createSubproblem(node, SP, PP);
+    PP->NIneq = 0;
+    PP->NPentIneq = 0;
+    PP->NHeptaIneq = 0;
+
+    // all components evaluated: X of node for branching
+    if (c == num_components) {
+        for (int a = 0; a < l; ++a) {
+            for (int b = 0; b < l; ++b) {
+                if (component[a] != component[b])
+                    Xn[b + a*n] = Xn[l + a*n] * Xn[l + b*n];
+            }
+        }
+
+        int nn = n * n;
+        int inc = 1;
+        dcopy_(&nn, Xn, &inc, X, &inc);
+
+        // combined solutions of all components
+        updateSolution(z);
+    }
+    free(Xn);
+
+    return value_z + total;
+}
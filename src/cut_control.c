@@ -0,0 +1,116 @@
+/* Online control of the cutting plane families (params.cut_control) */
+
+/*
+ * Every separation round of SDPbound is followed by bundle iterations, the
+ * decrease of the bound in these iterations is the gain of the round. Gain
+ * and time (separation of the family plus its share of the bundle time) are
+ * split over the families by their share of the dual multipliers after the
+ * bundle iterations, and summed per family and depth range in the shared
+ * statistics (shared_stats.c). Only
+ * rounds in which pentagonal or heptagonal inequalities were separated are
+ * recorded, so that all families are compared in the same phase of the
+ * cutting plane algorithm (gains decrease from round to round).
+ *
+ * Triangle inequalities are always separated, they are the reference: a
+ * family with rate (gain per second) r is used with effort
+ * min(1, r / r_triangle) (fraction of the cuts and separation trials, see
+ * setSeparationEffort) and switched off below CUT_CONTROL_OFF_RATIO. A family
+ * is used with full effort until it has CUT_CONTROL_MIN_ROUNDS observations
+ * in the depth range, a family that is off is still tried on every
+ * CUT_CONTROL_PROBE-th node so that its rate stays up to date.
+ */
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+
+#define CUT_CONTROL_MIN_ROUNDS 5
+#define CUT_CONTROL_OFF_RATIO 0.1
+#define CUT_CONTROL_MIN_EFFORT 0.25
+#define CUT_CONTROL_PROBE 10
+
+/* layout in shared statistics: gain, time and rounds per family and depth range */
+static int cc_offset = -1;
+static int num_nodes = 0;
+
+#define CC_GAIN(f, b)   (cc_offset + ((f) * SHARED_STATS_DEPTH_RANGES + (b)) * 3)
+#define CC_TIME(f, b)   (CC_GAIN(f, b) + 1)
+#define CC_ROUNDS(f, b) (CC_GAIN(f, b) + 2)
+
+
+void initCutControl(void) {
+
+    if (params.cut_control)
+        cc_offset = SharedStats_Register(3 * SHARED_STATS_DEPTH_RANGES * 3);
+}
+
+
+/*
+ * Families used for node: *use_pent and *use_hepta are cleared for families
+ * that do not pay off at the depth of node, the separation effort is set.
+ */
+void CutControl_Node(const BabNode *node, int *use_pent, int *use_hepta) {
+
+    if (cc_offset < 0)
+        return;
+
+    const double *stats = SharedStats_Get(0);
+    int b = SharedStats_DepthRange(node->level);
+    int probe = (++num_nodes % CUT_CONTROL_PROBE == 0);
+
+    double rate_tri = (stats[CC_TIME(CUT_TRIANGLE, b)] > 0.0) ?
+                      stats[CC_GAIN(CUT_TRIANGLE, b)] / stats[CC_TIME(CUT_TRIANGLE, b)] : 0.0;
+
+    for (int family = CUT_PENTAGONAL; family <= CUT_HEPTAGONAL; ++family) {
+
+        int *use = (family == CUT_PENTAGONAL) ? use_pent : use_hepta;
+        double effort = 1.0;
+
+        if (stats[CC_ROUNDS(family, b)] >= CUT_CONTROL_MIN_ROUNDS && rate_tri > 0.0) {
+
+            double ratio = stats[CC_GAIN(family, b)] / (stats[CC_TIME(family, b)] * rate_tri);
+
+            if (ratio < CUT_CONTROL_OFF_RATIO && !probe)
+                *use = 0;
+
+            effort = (ratio < CUT_CONTROL_MIN_EFFORT) ? CUT_CONTROL_MIN_EFFORT : (ratio < 1.0) ? ratio : 1.0;
+        }
+
+        setSeparationEffort(family, effort);
+    }
+}
+
+
+/*
+ * Record a separation round at depth level: separation time sep_time[f] per
+ * family, followed by bundle iterations of bundle_time seconds that decreased
+ * the bound by gain, mass[f] is the sum of the dual multipliers of family f
+ * afterwards.
+ */
+void CutControl_Round(int level, const double *mass, const double *sep_time, double bundle_time, double gain) {
+
+    if (cc_offset < 0 || (sep_time[CUT_PENTAGONAL] == 0.0 && sep_time[CUT_HEPTAGONAL] == 0.0))
+        return;
+
+    int b = SharedStats_DepthRange(level);
+    double total = mass[CUT_TRIANGLE] + mass[CUT_PENTAGONAL] + mass[CUT_HEPTAGONAL];
+
+    if (total <= 0.0)
+        return;
+
+    // the bundle method is not monotone: the bound can end above its value before the round
+    if (gain < 0.0)
+        gain = 0.0;
+
+    for (int family = CUT_TRIANGLE; family <= CUT_HEPTAGONAL; ++family) {
+
+        // families that were separated without effect only cost time
+        double share = mass[family] / total;
+        if (mass[family] == 0.0 && sep_time[family] == 0.0)
+            continue;
+
+        SharedStats_Add(CC_GAIN(family, b), share * gain);
+        SharedStats_Add(CC_TIME(family, b), sep_time[family] + share * bundle_time);
+        SharedStats_Add(CC_ROUNDS(family, b), 1.0);
+    }
+}
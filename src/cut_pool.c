@@ -0,0 +1,291 @@
+/* Saving cutting planes of a node and reusing them in other nodes */
+
+/*
+ * Cuts are stored with indices of the subproblem (free variables of the node
+ * followed by the last vertex). The pool stores them with original indices
+ * (0, ..., BabPbSize - 1 for the variables and BabPbSize for the last vertex),
+ * so they can be mapped to the subproblem of any other node. A cut is valid in
+ * every subproblem, the cuts containing a variable that is fixed in the other
+ * node are dropped.
+ */
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+
+extern Triangle_Inequality *Cuts;
+extern Pentagonal_Inequality *Pent_Cuts;
+extern Heptagonal_Inequality *Hepta_Cuts;
+
+
+/* sub_to_orig[i] = original index of subproblem index i, returns subproblem size */
+static int subToOrig(const BabNode *node, int *sub_to_orig) {
+
+    int n = 0;
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (!node->xfixed[i])
+            sub_to_orig[n++] = i;
+    }
+    sub_to_orig[n++] = BabPbSize;
+
+    return n;
+}
+
+
+/* orig_to_sub[v] = subproblem index of original index v, -1 if v is fixed */
+static void origToSub(const BabNode *node, int *orig_to_sub) {
+
+    int n = 0;
+    for (int i = 0; i < BabPbSize; ++i)
+        orig_to_sub[i] = (node->xfixed[i]) ? -1 : n++;
+    orig_to_sub[BabPbSize] = n;
+}
+
+
+/*
+ * Copy current cuts of subproblem P of node into a new pool.
+ * gamma are the dual multipliers of the cuts (triangle, pentagonal, heptagonal).
+ */
+CutPool *saveCuts(const BabNode *node, const Problem *P, const double *gamma) {
+
+    CutPool *pool;
+    int sub_to_orig[NMAX + 1];
+
+    subToOrig(node, sub_to_orig);
+
+    alloc(pool, CutPool);
+    pool->NIneq = P->NIneq;
+    pool->NPentIneq = P->NPentIneq;
+    pool->NHeptaIneq = P->NHeptaIneq;
+
+    // allocate at least one element so that empty pools need no special case
+    alloc_vector(pool->Cuts, P->NIneq + 1, Triangle_Inequality);
+    alloc_vector(pool->Pent_Cuts, P->NPentIneq + 1, Pentagonal_Inequality);
+    alloc_vector(pool->Hepta_Cuts, P->NHeptaIneq + 1, Heptagonal_Inequality);
+
+    for (int c = 0; c < P->NIneq; ++c) {
+        pool->Cuts[c] = Cuts[c];
+        pool->Cuts[c].i = sub_to_orig[Cuts[c].i];
+        pool->Cuts[c].j = sub_to_orig[Cuts[c].j];
+        pool->Cuts[c].k = sub_to_orig[Cuts[c].k];
+        pool->Cuts[c].y = gamma[c];
+    }
+
+    for (int c = 0; c < P->NPentIneq; ++c) {
+        pool->Pent_Cuts[c] = Pent_Cuts[c];
+        for (int l = 0; l < 5; ++l)
+            pool->Pent_Cuts[c].permutation[l] = sub_to_orig[Pent_Cuts[c].permutation[l]];
+        pool->Pent_Cuts[c].y = gamma[P->NIneq + c];
+    }
+
+    for (int c = 0; c < P->NHeptaIneq; ++c) {
+        pool->Hepta_Cuts[c] = Hepta_Cuts[c];
+        for (int l = 0; l < 7; ++l)
+            pool->Hepta_Cuts[c].permutation[l] = sub_to_orig[Hepta_Cuts[c].permutation[l]];
+        pool->Hepta_Cuts[c].y = gamma[P->NIneq + P->NPentIneq + c];
+    }
+
+    return pool;
+}
+
+
+/*
+ * Map the cuts of pool to the subproblem P of node: cuts are written to
+ * Cuts, Pent_Cuts and Hepta_Cuts, their dual multipliers to gamma.
+ * P must already be created with createSubproblem(node, ...).
+ * Returns the number of cuts in P.
+ */
+int loadCuts(const CutPool *pool, const BabNode *node, Problem *P, double *gamma) {
+
+    int orig_to_sub[NMAX + 1];
+    int perm[7];
+    int ok;
+
+    origToSub(node, orig_to_sub);
+
+    /* triangle inequalities: order i > j > k is kept since the map is monotone */
+    P->NIneq = 0;
+    for (int c = 0; c < pool->NIneq; ++c) {
+        const Triangle_Inequality *cut = &pool->Cuts[c];
+        if (orig_to_sub[cut->i] < 0 || orig_to_sub[cut->j] < 0 || orig_to_sub[cut->k] < 0)
+            continue;
+        Cuts[P->NIneq] = *cut;
+        Cuts[P->NIneq].i = orig_to_sub[cut->i];
+        Cuts[P->NIneq].j = orig_to_sub[cut->j];
+        Cuts[P->NIneq].k = orig_to_sub[cut->k];
+        ++(P->NIneq);
+    }
+
+    /* pentagonal inequalities */
+    P->NPentIneq = 0;
+    for (int c = 0; c < pool->NPentIneq; ++c) {
+        ok = 1;
+        for (int l = 0; l < 5 && ok; ++l) {
+            perm[l] = orig_to_sub[pool->Pent_Cuts[c].permutation[l]];
+            ok = (perm[l] >= 0);
+        }
+        if (!ok)
+            continue;
+        Pent_Cuts[P->NPentIneq] = pool->Pent_Cuts[c];
+        for (int l = 0; l < 5; ++l)
+            Pent_Cuts[P->NPentIneq].permutation[l] = perm[l];
+        ++(P->NPentIneq);
+    }
+
+    /* heptagonal inequalities */
+    P->NHeptaIneq = 0;
+    for (int c = 0; c < pool->NHeptaIneq; ++c) {
+        ok = 1;
+        for (int l = 0; l < 7 && ok; ++l) {
+            perm[l] = orig_to_sub[pool->Hepta_Cuts[c].permutation[l]];
+            ok = (perm[l] >= 0);
+        }
+        if (!ok)
+            continue;
+        Hepta_Cuts[P->NHeptaIneq] = pool->Hepta_Cuts[c];
+        for (int l = 0; l < 7; ++l)
+            Hepta_Cuts[P->NHeptaIneq].permutation[l] = perm[l];
+        ++(P->NHeptaIneq);
+    }
+
+    /* dual multipliers in the order used by op_B */
+    for (int c = 0; c < P->NIneq; ++c)
+        gamma[c] = Cuts[c].y;
+    for (int c = 0; c < P->NPentIneq; ++c)
+        gamma[P->NIneq + c] = Pent_Cuts[c].y;
+    for (int c = 0; c < P->NHeptaIneq; ++c)
+        gamma[P->NIneq + P->NPentIneq + c] = Hepta_Cuts[c].y;
+
+    return P->NIneq + P->NPentIneq + P->NHeptaIneq;
+}
+
+
+void freeCutPool(CutPool *pool) {
+
+    if (pool == NULL)
+        return;
+
+    free(pool->Cuts);
+    free(pool->Pent_Cuts);
+    free(pool->Hepta_Cuts);
+    free(pool);
+}
+
+
+/************** cache of cut pools of branched nodes (params.cut_cache) **************/
+
+/*
+ * A process keeps the active cuts of its last params.cut_cache branched nodes, so
+ * that the children it evaluates itself start from the cuts and multipliers
+ * of their parent (see SDPbound). An entry is removed when both children
+ * took it, the oldest entry is replaced when the cache is full. Children that
+ * are sent to other processes start without cuts.
+ */
+
+typedef struct CachedPool
+{
+    long long id;           // id of the branched node, -1 for empty entry
+    int uses;               // children that did not take the pool yet
+    double t;               // penalty parameter of the bundle method at the end
+    CutPool *pool;
+} CachedPool;
+
+static CachedPool *cut_cache = NULL;
+static int cache_next = 0;  // entry replaced next
+
+
+/* remove inactive cuts from pool (same threshold as purging in cutting_planes.c) */
+static void compactCutPool(CutPool *pool) {
+
+    int n = 0;
+    for (int c = 0; c < pool->NIneq; ++c) {
+        if (pool->Cuts[c].y >= 1e-5)
+            pool->Cuts[n++] = pool->Cuts[c];
+    }
+    pool->NIneq = n;
+
+    n = 0;
+    for (int c = 0; c < pool->NPentIneq; ++c) {
+        if (pool->Pent_Cuts[c].y >= 1e-5)
+            pool->Pent_Cuts[n++] = pool->Pent_Cuts[c];
+    }
+    pool->NPentIneq = n;
+
+    n = 0;
+    for (int c = 0; c < pool->NHeptaIneq; ++c) {
+        if (pool->Hepta_Cuts[c].y >= 1e-5)
+            pool->Hepta_Cuts[n++] = pool->Hepta_Cuts[c];
+    }
+    pool->NHeptaIneq = n;
+}
+
+
+/* store cuts of an evaluated node that is branched, t is the final penalty parameter of the bundle method */
+void CutCache_Store(const BabNode *node, const Problem *P, const double *gamma, double t) {
+
+    if (params.cut_cache <= 0 || P->NIneq + P->NPentIneq + P->NHeptaIneq == 0)
+        return;
+
+    if (cut_cache == NULL) {
+        alloc_vector(cut_cache, params.cut_cache, CachedPool);
+        for (int e = 0; e < params.cut_cache; ++e)
+            cut_cache[e].id = -1;
+    }
+
+    CachedPool *entry = &cut_cache[cache_next];
+    cache_next = (cache_next + 1) % params.cut_cache;
+
+    freeCutPool(entry->pool);
+    entry->id = node->id;
+    entry->uses = 2;
+    entry->t = t;
+    entry->pool = saveCuts(node, P, gamma);
+    compactCutPool(entry->pool);
+}
+
+
+/*
+ * Load the cuts and multipliers of the parent of node into P and gamma
+ * (P must already be created for node) and the final penalty parameter of
+ * the parent into t. Returns the number of cuts, 0 if the parent is not in
+ * the cache.
+ */
+int CutCache_Load(const BabNode *node, Problem *P, double *gamma, double *t) {
+
+    if (cut_cache == NULL || node->parent_id < 0)
+        return 0;
+
+    for (int e = 0; e < params.cut_cache; ++e) {
+
+        CachedPool *entry = &cut_cache[e];
+        if (entry->id != node->parent_id)
+            continue;
+
+        int num_cuts = loadCuts(entry->pool, node, P, gamma);
+        *t = entry->t;
+
+        if (--(entry->uses) == 0) {
+            freeCutPool(entry->pool);
+            entry->id = -1;
+            entry->pool = NULL;
+        }
+
+        return num_cuts;
+    }
+
+    return 0;
+}
+
+
+void CutCache_Free(void) {
+
+    if (cut_cache == NULL)
+        return;
+
+    for (int e = 0; e < params.cut_cache; ++e)
+        freeCutPool(cut_cache[e].pool);
+
+    free(cut_cache);
+    cut_cache = NULL;
+}
@@ -14,6 +14,23 @@ extern Heptagonal_Inequality *Hepta_List;
 
 extern double *X;
 
+/* fraction of params.TriIneq/PentIneq/HeptaIneq and of the trials used per separation round (cut_control.c) */
+static double separation_effort[3] = { 1.0, 1.0, 1.0 };
+
+
+void setSeparationEffort(int family, double effort) {
+    separation_effort[family] = effort;
+}
+
+
+/* params value scaled by the separation effort of family, at least 1 */
+static int scaledLimit(int family, int value) {
+    if (value <= 0)
+        return value;
+    int limit = (int) (separation_effort[family] * value);
+    return (limit > 1) ? limit : 1;
+}
+
 /************************* TRIANGLE INEQUALITIES *************************/
 
 /* evaluate triangle inequality */
@@ -53,6 +70,7 @@ double getViolated_TriangleInequalities(double *X, int N, Triangle_Inequality *L
     double LeastViolatedIneqValue = BIG_NUMBER; // minimum violation
     double maxAllIneq = -BIG_NUMBER;            // maximum violation
     double test_ineqvalue;                      // violation of current cut
+    int max_size = scaledLimit(CUT_TRIANGLE, params.TriIneq);
 
     // Loop through all inequalities
     for (int type = 1; type <= 4; ++type) {
@@ -71,7 +89,7 @@ double getViolated_TriangleInequalities(double *X, int N, Triangle_Inequality *L
 
                         // (1) put first params.TriIneq violated inequalities in list and 
                         //     keep track of the least violated inequality
-                        if (size < params.TriIneq) {
+                        if (size < max_size) {
 
                             // add ineq to the end of List
                             List[size].type  = type;
@@ -244,7 +262,10 @@ double getViolated_PentagonalInequalities(double *X, int N, Pentagonal_Inequalit
                             {1, 1, -1, -1, -1, 1, 1, -1, -1, -1, -1, -1, 1, 1, 1, -1, -1, 1, 1, 1, -1, -1, 1, 1, 1} };      // H3
 
 
-    for (int num_trial = 0; num_trial < params.Pent_Trials; ++num_trial) {
+    int max_size = scaledLimit(CUT_PENTAGONAL, params.PentIneq);
+    int num_trials = scaledLimit(CUT_PENTAGONAL, params.Pent_Trials);
+
+    for (int num_trial = 0; num_trial < num_trials && !timeLimitReached(); ++num_trial) {
         for (int type = 1; type <= 3; ++type) {
 
             test_ineqvalue = qap_simulated_annealing(&H[type-1][0], 5, X, N, pent);
@@ -257,7 +278,7 @@ double getViolated_PentagonalInequalities(double *X, int N, Pentagonal_Inequalit
 
                 // (1) put first params.PentIneq violated inequalities in list and 
                 //     keep track of the least violated inequality
-                if (size < params.PentIneq) {
+                if (size < max_size) {
 
                     // add ineq to the end of Pent_List
                     Pent_List[size].type  = type;
@@ -438,7 +459,10 @@ double getViolated_HeptagonalInequalities(double *X, int N, Heptagonal_Inequalit
                             {1, 1, 1, -1, -1, -1, -1, 1, 1, 1, -1, -1, -1, -1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1, 1, 1, 1, 1, -1, -1, -1, 1, 1, 1, 1, -1, -1, -1, 1, 1, 1, 1, -1, -1, -1, 1, 1, 1, 1} };    // H4
 
 
-    for (int num_trial = 0; num_trial < params.Hepta_Trials; ++num_trial) {
+    int max_size = scaledLimit(CUT_HEPTAGONAL, params.HeptaIneq);
+    int num_trials = scaledLimit(CUT_HEPTAGONAL, params.Hepta_Trials);
+
+    for (int num_trial = 0; num_trial < num_trials && !timeLimitReached(); ++num_trial) {
         for (int type = 1; type <= 4; ++type) {
 
             test_ineqvalue = qap_simulated_annealing(&H[type-1][0], 7, X, N, hept);
@@ -451,7 +475,7 @@ double getViolated_HeptagonalInequalities(double *X, int N, Heptagonal_Inequalit
 
                 // (1) put first params.PentIneq violated inequalities in list and 
                 //     keep track of the least violated inequality
-                if (size < params.HeptaIneq) {
+                if (size < max_size) {
 
                     // add ineq to the end of Pent_List
                     Hepta_List[size].type  = type;
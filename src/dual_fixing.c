@@ -0,0 +1,175 @@
+/* Variable fixing with the dual information of the SDP bound (params.dual_fixing, root probing) */
+
+/*
+ * The dual function of the cutting plane relaxation is an upper bound for
+ * every vector of nonnegative multipliers of the cuts: with the Lagrangian
+ * L0 = L - A^T(dual_gamma) of the subproblem, every cut-feasible y in {-1,1}^n
+ * satisfies y'Ly <= y'L0y + sum(dual_gamma).
+ *
+ * After the node was evaluated, the opposite side of the least fractional
+ * variables is bounded by contracting vertex i into the last vertex of L0
+ * (y[i] = s * y[n-1]) and solving the basic SDP relaxation of the contracted
+ * matrix, i.e. the dual function of the child at the multipliers
+ * of the parent with all cuts of the parent. If this bound is below
+ * Bab_LBGet() + 1, the variable is fixed to its rounded value in the node, so
+ * that both children inherit the fixing.
+ *
+ * Must be called directly after the node was evaluated: the cuts and
+ * multipliers are taken from PP and dual_gamma. If variables are fixed, PP,
+ * the cuts and dual_gamma are replaced by those of the reduced node (cuts on
+ * fixed variables are dropped).
+ */
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern Problem *SP;
+extern Problem *PP;
+extern double granularity;
+
+extern double *dual_gamma;
+
+
+/*
+ * Contract vertex a of the n x n matrix L0 into the last vertex with sign s
+ * (y[a] = s * y[n-1]), the result is the (n-1) x (n-1) matrix M.
+ */
+static void contractVertex(const double *L0, int n, int a, int s, double *M) {
+
+    int l = n - 1;
+    int m = n - 1;
+    int ii = 0;
+
+    for (int i = 0; i < n; ++i) {
+        if (i == a)
+            continue;
+        int jj = 0;
+        for (int j = 0; j < n; ++j) {
+            if (j == a)
+                continue;
+            M[jj + ii*m] = L0[j + i*n];
+            ++jj;
+        }
+        ++ii;
+    }
+
+    // last vertex of M is m - 1, row a moves to it
+    ii = 0;
+    for (int k = 0; k < n; ++k) {
+        if (k == a)
+            continue;
+        if (k != l) {
+            M[m - 1 + ii*m] += s * L0[a + k*n];
+            M[ii + (m - 1)*m] += s * L0[k + a*n];
+        }
+        ++ii;
+    }
+    M[m - 1 + (m - 1)*m] += 2 * s * L0[a + l*n] + L0[a + a*n];
+}
+
+
+/*
+ * Fix variables of node with the dual information: the max_candidates least
+ * fractional variables are tested. Returns the number of fixed variables.
+ */
+int dualFixing(BabNode *node, int max_candidates) {
+
+    if (PP->n < 3 || max_candidates <= 0)
+        return 0;
+
+    int candidates[max_candidates];
+    int num_candidates = selectIntegralCandidates(node, max_candidates, candidates);
+
+    // keep at least one free variable for branching
+    if (num_candidates == 0 || num_candidates >= BabPbSize - countFixedVariables(node))
+        return 0;
+
+    /* Lagrangian L0 = L - A^T(dual_gamma) of the subproblem */
+    int n = PP->n;
+    int nn = n * n;
+    int m = PP->NIneq + PP->NPentIneq + PP->NHeptaIneq;
+    int inc = 1;
+    int batch = (params.ipm_batch) ? IPM_BATCH : 1;
+    double *L0, *M[IPM_BATCH], *XX[IPM_BATCH];
+    double phi[IPM_BATCH];
+
+    alloc_matrix(L0, n, double);
+    for (int k = 0; k < batch; ++k) {
+        alloc_matrix(M[k], n - 1, double);
+        alloc_matrix(XX[k], n - 1, double);
+    }
+
+    dcopy_(&nn, PP->L, &inc, L0, &inc);
+    if (m > 0)
+        op_Bt(PP, L0, dual_gamma);
+
+    double constant = getFixedValue(node, SP);
+    for (int i = 0; i < m; ++i)
+        constant += dual_gamma[i];
+
+    int sub_index[BabPbSize];
+    int index = 0;
+    for (int i = 0; i < BabPbSize; ++i)
+        sub_index[i] = (node->xfixed[i]) ? -1 : index++;
+
+    int fix_value[num_candidates];
+    int num_fixed = 0;
+    double prune_below = (params.ipm_early_stop) ? Bab_LBGet() + granularity - constant : -BIG_NUMBER;
+
+    for (int c = 0; c < num_candidates; ++c)
+        fix_value[c] = -1;
+
+    // contracted matrices have the same size: batches of the batched IPM (params.ipm_batch)
+    for (int first = 0; first < num_candidates && !timeLimitReached(); first += batch) {
+
+        int count = (num_candidates - first < batch) ? num_candidates - first : batch;
+
+        for (int k = 0; k < count; ++k) {
+            int var = candidates[first + k];
+            int value = (node->fracsol[var] > 0.5) ? 1 : 0;
+
+            // opposite side: x[var] = 1 iff y[var] = y[n-1]
+            contractVertex(L0, n, sub_index[var], (value) ? -1 : 1, M[k]);
+        }
+
+        if (count > 1)
+            ipm_mc_pk_batch(M, XX, phi, count, n - 1, prune_below);
+        else
+            ipm_mc_pk_bounded(M[0], n - 1, XX[0], &phi[0], 0, prune_below, BIG_NUMBER);
+
+        for (int k = 0; k < count; ++k) {
+            int var = candidates[first + k];
+            if (phi[k] + constant < Bab_LBGet() + granularity) {
+                fix_value[first + k] = (node->fracsol[var] > 0.5) ? 1 : 0;
+                ++num_fixed;
+            }
+        }
+    }
+
+    free(L0);
+    for (int k = 0; k < batch; ++k) {
+        free(M[k]);
+        free(XX[k]);
+    }
+
+    if (num_fixed == 0)
+        return 0;
+
+    /* fix variables: subproblem and cuts of the reduced node */
+    CutPool *pool = saveCuts(node, PP, dual_gamma);
+
+    for (int c = 0; c < num_candidates; ++c) {
+        if (fix_value[c] >= 0) {
+            node->xfixed[candidates[c]] = 1;
+            node->sol.X[candidates[c]] = fix_value[c];
+            node->fracsol[candidates[c]] = (double) fix_value[c];
+        }
+    }
+
+    createSubproblem(node, SP, PP);
+    loadCuts(pool, node, PP, dual_gamma);
+    freeCutPool(pool);
+
+    return num_fixed;
+}
@@ -0,0 +1,180 @@
+/* Exact solution of small subproblems by Gray-code enumeration (params.enum_threshold) */
+
+/*
+ * If a node has fewer than params.enum_threshold free variables, the
+ * subproblem max y'Ly, y in {-1,1}^n, is solved exactly instead of computing
+ * the SDP bound: y[n-1] = 1 is fixed and the 2^(n-1) other vectors are
+ * enumerated in Gray-code order. Consecutive vectors differ in one entry y[k],
+ * with s = Ly the objective changes by -4 y[k] (s[k] - L[k][k] y[k]) and s is
+ * updated with column k of L in O(n) (the loop is vectorized by the compiler).
+ *
+ * With params.enum_threads > 1 the highest free entries are fixed in chunks
+ * that are distributed over the threads.
+ */
+
+#include <string.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern EvalStats eval_stats;
+
+/* at most 2^ENUM_PREFIX_BITS chunks for the threads */
+#define ENUM_PREFIX_BITS 6
+
+typedef struct EnumWork
+{
+    const double *L;
+    int n;
+    int prefix_bits;        // entries n-1-prefix_bits, ..., n-2 are fixed per chunk
+    int num_chunks;
+    int next;               // next chunk to enumerate
+    double best_value;
+    int best_y[NMAX + 1];
+    pthread_mutex_t lock;
+} EnumWork;
+
+
+/* enumerate all vectors of chunk c, the best one is stored in y_best */
+static double enumerateChunk(const EnumWork *work, int c, int *y_best) {
+
+    const double *L = work->L;
+    int n = work->n;
+    int q = n - 1 - work->prefix_bits;      // entries enumerated in this chunk
+    double y[n];
+    double s[n];
+
+    for (int i = 0; i < q; ++i)
+        y[i] = 1.0;
+    for (int b = 0; b < work->prefix_bits; ++b)
+        y[q + b] = ((c >> b) & 1) ? -1.0 : 1.0;
+    y[n - 1] = 1.0;
+
+    /* s = Ly and value = y'Ly of the first vector */
+    double value = 0.0;
+    for (int i = 0; i < n; ++i) {
+        s[i] = 0.0;
+        for (int j = 0; j < n; ++j)
+            s[i] += L[j + i*n] * y[j];
+        value += y[i] * s[i];
+    }
+
+    double best = value;
+    for (int i = 0; i < n; ++i)
+        y_best[i] = (int) y[i];
+
+    unsigned long long num_steps = 1ULL << q;
+
+    for (unsigned long long step = 1; step < num_steps; ++step) {
+
+        // Gray code: entry k changes
+        int k = __builtin_ctzll(step);
+        double yk = y[k];
+        const double *Lk = L + k*n;
+
+        value -= 4.0 * yk * (s[k] - Lk[k] * yk);
+
+        double scale = 2.0 * yk;
+        for (int j = 0; j < n; ++j)
+            s[j] -= scale * Lk[j];
+
+        y[k] = -yk;
+
+        if (value > best) {
+            best = value;
+            for (int i = 0; i < n; ++i)
+                y_best[i] = (int) y[i];
+        }
+    }
+
+    return best;
+}
+
+
+static void *enumerateThread(void *arg) {
+
+    EnumWork *work = (EnumWork *) arg;
+    int y[NMAX + 1];
+
+    while (1) {
+        pthread_mutex_lock(&work->lock);
+        int c = work->next++;
+        pthread_mutex_unlock(&work->lock);
+
+        if (c >= work->num_chunks)
+            break;
+
+        double value = enumerateChunk(work, c, y);
+
+        pthread_mutex_lock(&work->lock);
+        if (value > work->best_value) {
+            work->best_value = value;
+            memcpy(work->best_y, y, work->n * sizeof(int));
+        }
+        pthread_mutex_unlock(&work->lock);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Solve the subproblem PP of node exactly, the optimal solution is passed to
+ * updateSolution. Returns the optimal value of the node (an exact bound).
+ */
+double enumerateSubproblem(BabNode *node, Problem *PP) {
+
+    double t_start = MPI_Wtime();
+
+    EnumWork work;
+    work.L = PP->L;
+    work.n = PP->n;
+    work.prefix_bits = 0;
+    work.best_value = -BIG_NUMBER;
+    work.next = 0;
+    pthread_mutex_init(&work.lock, NULL);
+
+    int num_threads = (params.enum_threads > 1) ? params.enum_threads : 1;
+    if (num_threads > 1)
+        work.prefix_bits = (PP->n - 1 < ENUM_PREFIX_BITS) ? PP->n - 1 : ENUM_PREFIX_BITS;
+    work.num_chunks = 1 << work.prefix_bits;
+
+    if (num_threads > work.num_chunks)
+        num_threads = work.num_chunks;
+
+    if (num_threads > 1) {
+        pthread_t threads[num_threads];
+        for (int t = 0; t < num_threads; ++t)
+            pthread_create(&threads[t], NULL, enumerateThread, &work);
+        for (int t = 0; t < num_threads; ++t)
+            pthread_join(threads[t], NULL);
+    }
+    else {
+        enumerateThread(&work);
+    }
+
+    pthread_mutex_destroy(&work.lock);
+
+    /* optimal solution in the {0,1} model: x[i] = 1 iff y[i] = y[n-1] */
+    int x[BabPbSize];
+    int index = 0;
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (node->xfixed[i])
+            x[i] = node->sol.X[i];
+        else
+            x[i] = (work.best_y[index++] + 1) / 2;
+    }
+    resolveLinkedVariables(node->xfixed, node->sol.X, x);
+
+    updateSolution(x);
+
+    for (int i = 0; i < BabPbSize; ++i)
+        node->fracsol[i] = (double) x[i];
+
+    // no SDP bound was computed for this node
+    memset(&eval_stats, 0, sizeof(EvalStats));
+    eval_stats.time_heuristic = MPI_Wtime() - t_start;
+
+    return evaluateSolution(x);
+}
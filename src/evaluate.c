@@ -3,6 +3,33 @@
 extern BiqBinParameters params;
 extern int BabPbSize;      
 
+static void createContractedSubproblem(BabNode *node, Problem *SP, Problem *PP);
+static void createSparseSubproblem(BabNode *node, const SparseMatrix *S, Problem *PP);
+static double getContractedFixedValue(BabNode *node, Problem *SP);
+static int deriveSubproblem(BabNode *node, Problem *SP, Problem *PP);
+static void storeSubproblem(BabNode *node, const Problem *PP, double fixedvalue);
+static double computeFixedValue(BabNode *node, Problem *SP);
+
+/*
+ * Subproblems of the last params.incremental_subproblem nodes evaluated by
+ * this process. The subproblem of a node that has all fixings of a cached
+ * node (e.g. of its parent) is derived by deleting the rows and columns of
+ * the newly fixed variables and updating the linear part.
+ */
+typedef struct SubproblemCache
+{
+    int valid;
+    int xfixed[NMAX];
+    int sol[NMAX];
+    int n;                  // size of the subproblem
+    double *L;              // PP->L of the node
+    double fixedvalue;      // getFixedValue of the node
+} SubproblemCache;
+
+static SubproblemCache *cache = NULL;
+static int cache_next = 0;              // slot for the next node
+static int cache_last = -1;             // slot of the last evaluated node
+
 /*
  * Evaluate a specific node.
  * This function computes the upper and lower bounds of a specific node
@@ -10,13 +37,30 @@ extern int BabPbSize;
  */
 double Evaluate(BabNode *node, Problem *SP, Problem *PP, int rank) {
     
-    // create subproblem PP
-    createSubproblem(node, SP, PP);
+    // create subproblem PP, if possible from the cached subproblem of an ancestor
+    if (!params.incremental_subproblem || !deriveSubproblem(node, SP, PP)) {
+        createSubproblem(node, SP, PP);
+        if (params.incremental_subproblem && !hasLinkedVariables(node))
+            storeSubproblem(node, PP, computeFixedValue(node, SP));
+    }
+
+    // small subproblems are solved exactly
+    if (PP->n - 1 < params.enum_threshold)
+        return latticeFloor(enumerateSubproblem(node, PP));
+
+    // independent parts of the subproblem are bounded separately
+    if (params.components && PP->n > 2) {
+        int component[PP->n - 1];
+        int num_components = findComponents(PP, component);
+        if (num_components > 1)
+            return latticeFloor(evaluateComponents(node, SP, PP, rank, component, num_components));
+    }
 
     // compute the SDP upper bound and run heuristic
     double bound = SDPbound(node, SP, PP, rank); 
 
-    return bound;
+    // objective values are multiples of granularity
+    return latticeFloor(bound);
 }
 
 
@@ -37,9 +81,22 @@ double Evaluate(BabNode *node, Problem *SP, Problem *PP, int rank) {
  */
 void createSubproblem(BabNode *node, Problem *SP, Problem *PP) {
 
+    // pair branching: linked variables are contracted into their partners
+    if (hasLinkedVariables(node)) {
+        createContractedSubproblem(node, SP, PP);
+        return;
+    }
+
     // Subproblem size is the number of non-fixed variables in the node
     PP->n = BabPbSize + 1 - countFixedVariables(node);
 
+    // sparse graphs: only the nonzeros of the rows of free variables are read
+    const SparseMatrix *S = sparseLaplacian();
+    if (S != NULL) {
+        createSparseSubproblem(node, S, PP);
+        return;
+    }
+
     /* build objective:
      * Laplacian;
      * z'*L*z = sum_{i != fixed, j != fixed} L_ij*xi*xj (smaller matrix L_bar for subproblem)
@@ -115,6 +172,52 @@ void createSubproblem(BabNode *node, Problem *SP, Problem *PP) {
 }
 
 
+/* createSubproblem with the sparse Laplacian S of SP (PP->n is set), entries are scaled by 1/4 when written */
+static void createSparseSubproblem(BabNode *node, const SparseMatrix *S, Problem *PP) {
+
+    int n = PP->n;
+    int sub_index[BabPbSize];
+    int index = 0;
+
+    for (int i = 0; i < BabPbSize; ++i)
+        sub_index[i] = (node->xfixed[i]) ? -1 : index++;
+
+    for (int i = 0; i < n * n; ++i)
+        PP->L[i] = 0.0;
+
+    double sum = 0.0;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+
+        int a = sub_index[i];
+        if (a < 0)
+            continue;
+
+        double row_sum = S->diag[i];
+        double fixed_row = 0.0;     // entries of vertices fixed to 1
+
+        for (int e = S->row_start[i]; e < S->row_start[i + 1]; ++e) {
+            int j = S->col[e];
+            if (sub_index[j] >= 0) {
+                PP->L[sub_index[j] + a*n] = 0.25 * S->val[e];
+                row_sum += S->val[e];
+            }
+            else if (node->sol.X[j] == 1)
+                fixed_row += S->val[e];
+        }
+
+        // linear part: twice added to diagonal, last column and last row
+        PP->L[a + a*n] = 0.25 * (S->diag[i] + 2*fixed_row);
+        PP->L[n - 1 + a*n] = 0.25 * (row_sum + 2*fixed_row);
+        PP->L[a + (n - 1)*n] = 0.25 * (row_sum + 2*fixed_row);
+
+        sum += row_sum + 2*fixed_row;
+    }
+
+    PP->L[n - 1 + (n - 1)*n] = 0.25 * sum;
+}
+
+
 /* 
  * Return the fixed value of the node.
  * The fixed value is contribution of the fixed variables to 
@@ -122,6 +225,33 @@ void createSubproblem(BabNode *node, Problem *SP, Problem *PP) {
  */
 double getFixedValue(BabNode *node, Problem *SP) {
 
+    if (hasLinkedVariables(node))
+        return getContractedFixedValue(node, SP);
+
+    // same fixings as the last evaluated node
+    if (cache_last >= 0) {
+        const SubproblemCache *entry = &cache[cache_last];
+        int same = 1;
+        for (int i = 0; i < BabPbSize && same; ++i)
+            same = (node->xfixed[i] == entry->xfixed[i]) && (!node->xfixed[i] || node->sol.X[i] == entry->sol[i]);
+        if (same)
+            return entry->fixedvalue;
+    }
+
+    return computeFixedValue(node, SP);
+}
+
+
+static double computeFixedValue(BabNode *node, Problem *SP) {
+
+    // objective of the solution that is 0 on the free variables
+    if (sparseLaplacian() != NULL) {
+        int x[BabPbSize];
+        for (int i = 0; i < BabPbSize; ++i)
+            x[i] = (node->xfixed[i]) ? node->sol.X[i] : 0;
+        return evaluateSolution(x);
+    }
+
     int N = SP->n;
     double fixedvalue = 0.0;
 
@@ -136,3 +266,319 @@ double getFixedValue(BabNode *node, Problem *SP) {
     return fixedvalue;
 
 }
+
+
+/******************* incremental subproblems (children) *******************/
+
+static void storeSubproblem(BabNode *node, const Problem *PP, double fixedvalue) {
+
+    if (cache == NULL) {
+        alloc_vector(cache, params.incremental_subproblem, SubproblemCache);
+    }
+
+    SubproblemCache *entry = &cache[cache_next];
+    cache_last = cache_next;
+    cache_next = (cache_next + 1) % params.incremental_subproblem;
+
+    if (entry->L == NULL) {
+        alloc_matrix(entry->L, BabPbSize + 1, double);
+    }
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        entry->xfixed[i] = node->xfixed[i];
+        entry->sol[i] = node->sol.X[i];
+    }
+
+    int nn = PP->n * PP->n;
+    int inc = 1;
+    dcopy_(&nn, PP->L, &inc, entry->L, &inc);
+
+    entry->n = PP->n;
+    entry->fixedvalue = fixedvalue;
+    entry->valid = 1;
+}
+
+
+/* cached subproblem with all fixings of node and the fewest free variables, NULL if none */
+static const SubproblemCache *findAncestor(const BabNode *node) {
+
+    const SubproblemCache *best = NULL;
+
+    for (int e = 0; cache != NULL && e < params.incremental_subproblem; ++e) {
+
+        const SubproblemCache *entry = &cache[e];
+        if (!entry->valid || (best != NULL && entry->n >= best->n))
+            continue;
+
+        int contained = 1;
+        for (int i = 0; i < BabPbSize && contained; ++i)
+            contained = !entry->xfixed[i] || (node->xfixed[i] == 1 && node->sol.X[i] == entry->sol[i]);
+
+        if (contained)
+            best = entry;
+    }
+
+    return best;
+}
+
+
+/*
+ * Subproblem of node from a cached subproblem whose fixings node has.
+ * With D the newly fixed variables and D1 those fixed to 1, for a free
+ * variable j (see createSubproblem, entries of SP->L are scaled by 1/4):
+ *   last column: - sum_{k in D} L_jk + 2 sum_{k in D1} L_jk
+ *   diagonal:      2 sum_{k in D1} L_jk
+ * and the fixed value grows by the terms of D1 with D1 and the fixed ones.
+ * Returns 0 if the subproblem can not be derived.
+ */
+static int deriveSubproblem(BabNode *node, Problem *SP, Problem *PP) {
+
+    if (hasLinkedVariables(node))
+        return 0;
+
+    const SubproblemCache *entry = findAncestor(node);
+    if (entry == NULL)
+        return 0;
+
+    int N = SP->n;
+    int np = entry->n;
+    int keep[np];                   // subproblem indices of the cached node that stay free
+    int orig[np];                   // original index of keep[j]
+    int new_fixed[np];
+    int n = 0, num_new = 0, a = 0;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (entry->xfixed[i])
+            continue;
+        if (node->xfixed[i])
+            new_fixed[num_new++] = i;
+        else {
+            keep[n] = a;
+            orig[n++] = i;
+        }
+        ++a;
+    }
+    keep[n++] = np - 1;
+
+    /* rows and columns of the free variables and the last vertex */
+    for (int i = 0; i < n; ++i) {
+        const double *row = entry->L + keep[i]*np;
+        double *dest = PP->L + i*n;
+        for (int j = 0; j < n; ++j)
+            dest[j] = row[keep[j]];
+    }
+
+    /* linear part */
+    double sum = 0.0;
+    for (int j = 0; j < n - 1; ++j) {
+
+        const double *row = SP->L + orig[j]*N;
+        double removed = 0.0, fixed_one = 0.0;
+
+        for (int d = 0; d < num_new; ++d) {
+            int k = new_fixed[d];
+            removed += row[k];
+            if (node->sol.X[k] == 1)
+                fixed_one += row[k];
+        }
+
+        PP->L[j + j*n] += 0.5 * fixed_one;
+
+        double c = PP->L[n - 1 + j*n] - 0.25 * removed + 0.5 * fixed_one;
+        PP->L[n - 1 + j*n] = c;
+        PP->L[j + (n - 1)*n] = c;
+        sum += c;
+    }
+    PP->L[n - 1 + (n - 1)*n] = sum;
+    PP->n = n;
+
+    /* fixed value: x[k] = 1 for k in D1 adds L_kk + 2 sum_{i fixed to 1 before k} L_ik */
+    double fixedvalue = entry->fixedvalue;
+    int ones[BabPbSize];
+    int num_ones = 0;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (entry->xfixed[i] && entry->sol[i] == 1)
+            ones[num_ones++] = i;
+    }
+
+    for (int d = 0; d < num_new; ++d) {
+        int k = new_fixed[d];
+        if (node->sol.X[k] != 1)
+            continue;
+        const double *row = SP->L + k*N;
+        double cross = 0.0;
+        for (int t = 0; t < num_ones; ++t)
+            cross += row[ones[t]];
+        fixedvalue += row[k] + 2.0 * cross;
+        ones[num_ones++] = k;
+    }
+
+    storeSubproblem(node, PP, fixedvalue);
+
+    return 1;
+}
+
+
+void freeSubproblemCache(void) {
+
+    for (int e = 0; cache != NULL && e < params.incremental_subproblem; ++e)
+        free(cache[e].L);
+    free(cache);
+    cache = NULL;
+    cache_last = -1;
+}
+
+
+/********************** pair branching: linked variables **********************/
+
+/*
+ * A linked variable i (xfixed[i] == LINKED) satisfies x[i] = x[p] XOR parity
+ * with sol.X[i] = 2 * p + parity. Partner p was free when the link was
+ * created, but may be fixed or linked itself later.
+ */
+
+/* returns 1 if some variable of node is linked */
+int hasLinkedVariables(const BabNode *node) {
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (node->xfixed[i] == LINKED)
+            return 1;
+    }
+
+    return 0;
+}
+
+
+/* follow links from variable i: returns free or fixed variable r with x[i] = x[r] XOR parity */
+int resolveVariable(const int *xfixed, const int *sol_X, int i, int *parity) {
+
+    *parity = 0;
+    while (xfixed[i] == LINKED) {
+        *parity ^= sol_X[i] & 1;
+        i = sol_X[i] >> 1;
+    }
+
+    return i;
+}
+
+
+/* set linked variables of solution x (free and fixed variables of x must be set) */
+void resolveLinkedVariables(const int *xfixed, const int *sol_X, int *x) {
+
+    int parity;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (xfixed[i] == LINKED)
+            x[i] = x[resolveVariable(xfixed, sol_X, i, &parity)] ^ parity;
+    }
+}
+
+
+/*
+ * Every variable is written as x[i] = a[i] + b[i] * y[s[i]], where y are the
+ * free variables of the subproblem: b[i] = 0 if x[i] is determined by fixed
+ * variables, b[i] = 1 (-1) if it equals (is opposite to) free variable s[i].
+ */
+static void affineMap(const BabNode *node, int *a, int *b, int *s) {
+
+    int sub_index[BabPbSize];
+    int parity, r;
+    int n = 0;
+
+    for (int i = 0; i < BabPbSize; ++i)
+        sub_index[i] = (node->xfixed[i]) ? -1 : n++;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        r = resolveVariable(node->xfixed, node->sol.X, i, &parity);
+        if (node->xfixed[r]) {
+            a[i] = node->sol.X[r] ^ parity;
+            b[i] = 0;
+            s[i] = -1;
+        }
+        else {
+            a[i] = parity;
+            b[i] = (parity) ? -1 : 1;
+            s[i] = sub_index[r];
+        }
+    }
+}
+
+
+/*
+ * createSubproblem for nodes with linked variables.
+ * With x = a + B y the objective x'Lx = y'(B'LB)y + 2 (B'La)'y + a'La.
+ * Since y is binary, the linear part is added to the diagonal: Q = B'LB + 2 Diag(B'La),
+ * and the subproblem in {-1,1} variables is 1/4 [Q, Qe; e'Q, e'Qe].
+ */
+static void createContractedSubproblem(BabNode *node, Problem *SP, Problem *PP) {
+
+    int N = SP->n;
+    int a[BabPbSize], b[BabPbSize], s[BabPbSize];
+    double La[BabPbSize];
+
+    affineMap(node, a, b, s);
+
+    PP->n = BabPbSize + 1 - countFixedVariables(node);
+    int n = PP->n;
+    int nn = n * n;
+
+    for (int i = 0; i < nn; ++i)
+        PP->L[i] = 0.0;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        La[i] = 0.0;
+        for (int j = 0; j < BabPbSize; ++j)
+            La[i] += SP->L[j + i*N] * a[j];
+    }
+
+    // Q = B'LB + 2 Diag(B'La) in upper left corner
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (b[i] == 0)
+            continue;
+
+        PP->L[s[i] + s[i]*n] += 2 * b[i] * La[i];
+
+        for (int j = 0; j < BabPbSize; ++j) {
+            if (b[j] != 0)
+                PP->L[s[j] + s[i]*n] += b[i] * b[j] * SP->L[j + i*N];
+        }
+    }
+
+    // last column and row: Qe, last element: e'Qe
+    double sum = 0.0;
+    for (int i = 0; i < n - 1; ++i) {
+        double row_sum = 0.0;
+        for (int j = 0; j < n - 1; ++j)
+            row_sum += PP->L[j + i*n];
+        PP->L[n - 1 + i*n] = row_sum;
+        PP->L[i + (n - 1)*n] = row_sum;
+        sum += row_sum;
+    }
+    PP->L[n - 1 + (n - 1)*n] = sum;
+
+    /* multiple by 1/4 the whole matrix L */
+    double alpha = 0.25;
+    int inc = 1;
+    dscal_(&nn, &alpha, PP->L, &inc);
+}
+
+
+/* getFixedValue for nodes with linked variables: a'La */
+static double getContractedFixedValue(BabNode *node, Problem *SP) {
+
+    int N = SP->n;
+    int a[BabPbSize], b[BabPbSize], s[BabPbSize];
+    double fixedvalue = 0.0;
+
+    affineMap(node, a, b, s);
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (a[i] == 0)
+            continue;
+        for (int j = 0; j < BabPbSize; ++j)
+            fixedvalue += SP->L[j + i*N] * a[j];
+    }
+
+    return fixedvalue;
+}
@@ -11,6 +11,9 @@ int stopped = 0;                    // true if the algorithm stopped at root nod
 double root_bound;                  // SDP upper bound at root node
 double TIME;                        // CPU time
 double diff;			            // difference between basic SDP relaxation and bound with added cutting planes  	
+double bound_offset = 0.0;          // added to the bound of the evaluated node before comparing with the lower bound (components)
+double prune_threshold = -BIG_NUMBER; // the evaluated node is pruned if the bound of the relaxation (without fixed value) is below (params.ipm_early_stop)
+double granularity = 1.0;           // all objective values are multiples of granularity (computeGranularity)
 /********************************************************/
 
 
@@ -22,6 +25,7 @@ double *X;                          // Stores current (psd) X (primal solution).
 double *Z;                          // Cholesky factorization: X = ZZ^T (used for heuristic)
 double *X_bundle;                   // containts bundle matrices as columns
 double *X_test;                     // matching pair X for gamma_test
+double *L_eval;                     // L - A^T(gamma) of the current dual function evaluation (fct_eval, main thread only)
 
 /* DUAL variables */
 double *dual_gamma;                      // (nonnegative) dual multiplier to cutting planes
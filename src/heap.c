@@ -16,21 +16,22 @@ int Bab_numEvalNodes(void) { return Bab_numNodes; }
 void Bab_incEvalNodes(void) { ++Bab_numNodes; }
 
 /* Function that determines priority of the BaBNode-s.
- * Priority is based on upper bound: 
- * takes node with higher upper bound (worst bound) first
+ * Priority is the upper bound: 
+ * takes node with higher upper bound (worst bound) first,
+ * or the learned score with node_selection = 1 (setNodePriority in scorer.c)
  *
  * Returns 1 if node1 has bigger priority than node2 and
  *        -1 if other way around
  */
 inline int compare_Nodes(const BabNode* node1, const BabNode* node2) {
 
-    return ( (node1->upper_bound > node2->upper_bound) ? 1 : -1 );           
+    return ( (node1->priority > node2->priority) ? 1 : -1 );           
 }
 
 
-inline void swap_entries(int i, int j) {
+inline void swap_entries(Heap *h, int i, int j) {
 
-    BabNode** data = heap->data;
+    BabNode** data = h->data;
     BabNode* t;
 
     t       = data[i];
@@ -39,41 +40,41 @@ inline void swap_entries(int i, int j) {
 }
 
 /* heapify down from root */
-static void heapify_down(int current) {
+static void heapify_down(Heap *h, int current) {
 
-    BabNode** data = heap->data;  
+    BabNode** data = h->data;  
     int child = 2 * current + 1;  // left child
 
     /* 
      * place element in root in correct position to maintain heap
      */
-    if (child + 1 < heap->used) {// right child check
+    if (child + 1 < h->used) {// right child check
       if (compare_Nodes(data[child + 1], data[child]) > 0)
          child++;
     }
      
-    while(child < heap->used && compare_Nodes(data[current], data[child]) < 0)
+    while(child < h->used && compare_Nodes(data[current], data[child]) < 0)
     {
-        swap_entries(current, child);
+        swap_entries(h, current, child);
 
         current = child;
         child   = 2 * current + 1;
       
-        if (child + 1 < heap->used)
+        if (child + 1 < h->used)
             if (compare_Nodes(data[child + 1], data[child]) > 0)
                 child++;
     }
 }
 
 /* heapify up from last node*/
-static void heapify_up(int current) {
+static void heapify_up(Heap *h, int current) {
 
-    BabNode** data = heap->data;
+    BabNode** data = h->data;
     int parent = (current-1) / 2;
 
     while(current > 0 && compare_Nodes(data[parent], data[current]) < 0)
     {
-        swap_entries(current, parent);
+        swap_entries(h, current, parent);
         current = parent;
         parent  = (current-1) / 2;
     }
@@ -94,40 +95,79 @@ Heap* Init_Heap(int size) {
 }
 
 
-int isPQEmpty(void) {
-   return heap->used == 0;
-}
-
-
-BabNode* Bab_PQPop(void) {
+/* take and remove the node with the highest priority from heap h */
+BabNode* Heap_Pop(Heap *h) {
 
    /* safe root, swap it with last node and heapify */     
-   BabNode *node = heap->data[0];
+   BabNode *node = h->data[0];
 
-   heap->data[0] = NULL;
-   heap->used--;
+   h->data[0] = NULL;
+   h->used--;
 
-   swap_entries(0, heap->used);
+   swap_entries(h, 0, h->used);
    
-   heapify_down(0);
+   heapify_down(h, 0);
       
    return node;
 }
 
 
-void Bab_PQInsert(BabNode *node) {
+/* insert node into heap h */
+void Heap_Insert(Heap *h, BabNode *node) {
    
     // check heap size
-    if (heap->size == heap->used) {
+    if (h->size == h->used) {
         puts("\nERROR: Maximum size of heap reached.\n");
         MPI_Abort(MPI_COMM_WORLD,10);
     }
    
    /* place new node at the end of heap and heapify */
-   heap->data[heap->used] = node;
-   heap->used++;
+   h->data[h->used] = node;
+   h->used++;
+
+   heapify_up(h, h->used - 1);
+}
 
-   heapify_up(heap->used - 1);
+
+/* remove and return the node at position index of heap h */
+BabNode* Heap_Remove(Heap *h, int index) {
+
+    BabNode *node = h->data[index];
+
+    h->used--;
+    swap_entries(h, index, h->used);
+    h->data[h->used] = NULL;
+
+    // moved element can violate the heap property in both directions
+    if (index < h->used) {
+        heapify_up(h, index);
+        heapify_down(h, index);
+    }
+
+    return node;
+}
+
+
+/* restore heap property of the whole array (Floyd's construction) */
+void Heap_Rebuild(Heap *h) {
+
+    for (int i = h->used / 2 - 1; i >= 0; --i)
+        heapify_down(h, i);
+}
+
+
+int isPQEmpty(void) {
+   return heap->used == 0;
+}
+
+
+BabNode* Bab_PQPop(void) {
+   return Heap_Pop(heap);
+}
+
+
+void Bab_PQInsert(BabNode *node) {
+   Heap_Insert(heap, node);
 }
 
 
@@ -162,6 +202,15 @@ BabNode* newNode(BabNode *parentNode) {
     // child is one level deeper than parent
     node->level = (parentNode == NULL) ? 0 : parentNode->level + 1;
 
+    // child inherits the bound of the parent until it is evaluated
+    node->upper_bound = (parentNode == NULL) ? BIG_NUMBER : parentNode->upper_bound;
+    node->prebound = node->upper_bound;
+
+    // tree information for the trace, id (Trace_NextId) and branch_var are set by the caller
+    node->id = -1;
+    node->parent_id = (parentNode == NULL) ? -1 : parentNode->id;
+    node->branch_var = -1;
+
     return node;
 }
 
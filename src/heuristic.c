@@ -8,15 +8,32 @@
 extern double *X;
 extern double *Z;       // stores Cholesky decomposition: X = ZZ^T
 
+static double hyperplaneRounding(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X,
+                                 const double *Zs, int *x, int num);
+
 double runHeuristic(Problem *P0, Problem *P, BabNode *node, int *x){
+    double heur_val;
+
     #ifdef PURE_C
-        return runHeuristic_unpacked(P0->L, P0->n, P->L, P->n, node->xfixed, node->sol.X, x);
+        heur_val = runHeuristic_unpacked(P0->L, P0->n, P->L, P->n, node->xfixed, node->sol.X, x);
     #else
-        return wrapped_heuristic(P0, P, node, x);
+        heur_val = wrapped_heuristic(P0, P, node, x);
     #endif
+
+    // custom heuristics may leave variables linked by pair branching unset
+    resolveLinkedVariables(node->xfixed, node->sol.X, x);
+
+    return heur_val;
 }
 
 double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X, int *x) {
+    return runHeuristicOnMatrix(P0_L, P0_N, P_L, P_N, node_xfixed, node_sol_X, X, Z, x);
+}
+
+
+/* heuristic on the primal matrix Xs with workspace Zs (both n x n): no global state, used by helper threads */
+double runHeuristicOnMatrix(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X,
+                            double *Xs, double *Zs, int *x) {
 
     // Problem *P0 ... the original problem
     // Problem *P  ... the current subproblem
@@ -50,6 +67,7 @@ double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int
             ++index;
         }
     }
+    resolveLinkedVariables(node_xfixed, node_sol_X, temp_x);
 
     double fh = evaluateSolution(temp_x);
 
@@ -58,14 +76,14 @@ double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int
     double alpha;
 
     // Z = X
-    dcopy_(&nn, X, &inc, Z, &inc);
+    dcopy_(&nn, Xs, &inc, Zs, &inc);
 
     while (done < 2) {
 
         ++done;
         
         // compute Cholesky factorization
-        dpotrf_(&UPLO, &n, Z, &n, &info);
+        dpotrf_(&UPLO, &n, Zs, &n, &info);
 
         if (info != 0) {
             fprintf(stderr, "%s: Problem with Cholesky factorization \
@@ -76,11 +94,11 @@ double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int
         // set lower triangle of Z to zero
         for (int i = 0; i < n; ++i)
             for (int j = 0; j < i; ++j)
-                Z[j + i*n] = 0.0;
+                Zs[j + i*n] = 0.0;
 
         // Goemans-Williamson heuristic
         // RK heur_val = wrapped_heuristic(P0, P, node, x, P0->n);
-        heur_val = GW_heuristic(P0_L, P0_N , P_L, P_N, node_xfixed, node_sol_X, x, P0_N);  // RK
+        heur_val = hyperplaneRounding(P0_L, P0_N , P_L, P_N, node_xfixed, node_sol_X, Zs, x, P0_N);  // RK
         if (heur_val > fh) {
 
             done = 0;
@@ -104,10 +122,10 @@ double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int
 
         // Z = (1-constant)*X + constant* xh *xh'
         alpha = 1.0 - constant;
-        dcopy_(&nn, X, &inc, Z, &inc);
-        dscal_(&nn, &alpha, Z, &inc);
+        dcopy_(&nn, Xs, &inc, Zs, &inc);
+        dscal_(&nn, &alpha, Zs, &inc);
         alpha = constant;
-        dsyr_(&UPLO, &n, &alpha, xh, &inc, Z, &n);
+        dsyr_(&UPLO, &n, &alpha, xh, &inc, Zs, &n);
 
     }
 
@@ -117,6 +135,13 @@ double runHeuristic_unpacked(double *P0_L, int P0_N , double *P_L, int P_N, int
 
 /* Goemans-Williamson random hyperplane heuristic */
 double GW_heuristic(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X, int *x, int num) {
+    return hyperplaneRounding(P0_L, P0_N, P_L, P_N, node_xfixed, node_sol_X, Z, x, num);
+}
+
+
+/* Goemans-Williamson rounding with the Cholesky factor Zs of the primal matrix */
+static double hyperplaneRounding(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfixed, int *node_sol_X,
+                                 const double *Zs, int *x, int num) {
 
     // Problem *P0 ... the original problem
     // Problem *P  ... the current subproblem
@@ -135,6 +160,9 @@ double GW_heuristic(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfi
     double best = -BIG_NUMBER;          // best lower bound found
     double v[N];                        // defines random hyperplane v   
 
+    // sparse graphs: nonzeros of P_L for the local search, built once for all hyperplanes
+    SparseMatrix *P_sparse = (sparseLaplacian() != NULL) ? sparseFromDense(P_L, P_N, P_N) : NULL;
+
 
     for (int count = 0; count < num; ++count) {
 
@@ -148,7 +176,7 @@ double GW_heuristic(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfi
 
                 sca = 0.0;
                 for (int j = 0; j < N; ++j)
-                    sca += v[j] * Z[j * N + index];
+                    sca += v[j] * Zs[j * N + index];
 
                 if (sca < 0) {
 
@@ -165,7 +193,10 @@ double GW_heuristic(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfi
         }
 
         // improve feasible solution through 1-opt
-        mc_1opt(temp_x, P_L, P_N);
+        if (P_sparse != NULL)
+            mc_1opt_sparse(temp_x, P_sparse);
+        else
+            mc_1opt(temp_x, P_L, P_N);
 
         // store local cut temp_x into global cut sol
         index = 0;
@@ -177,11 +208,14 @@ double GW_heuristic(double *P0_L, int P0_N , double *P_L, int P_N, int *node_xfi
                 ++index;
             }
         }
+        resolveLinkedVariables(node_xfixed, node_sol_X, sol);
 
         update_best(x, sol, &best, P0_N);
       
     }
 
+    freeSparseMatrix(P_sparse);
+
     return best;
 }
 
@@ -296,6 +330,70 @@ double mc_1opt(int *x, double *P_L, int P_N) {
 }
 
 
+/*
+ * mc_1opt with the nonzeros of the objective matrix in S:
+ * a flip of x[index] only changes Lx and delta in the nonzeros of row index.
+ */
+// NOTE: this function is working in {-1,1} model!
+double mc_1opt_sparse(int *x, const SparseMatrix *S) {
+
+    int N = S->n;
+
+    double *Lx, *delta;
+    alloc_vector(Lx, N, double);
+    alloc_vector(delta, N, double);
+
+    // Lx = L*x, cost = x'*Lx, delta = d - x.*Lx
+    double cost = 0.0;
+
+    for (int i = 0; i < N; ++i) {
+        Lx[i] = S->diag[i] * x[i];
+        for (int e = S->row_start[i]; e < S->row_start[i + 1]; ++e)
+            Lx[i] += S->val[e] * x[S->col[e]];
+        cost += x[i] * Lx[i];
+        delta[i] = S->diag[i] - x[i] * Lx[i];
+    }
+
+    /*** main loop ***/
+    while (1) {
+
+        // [best, index] = max(delta)
+        double best = -BIG_NUMBER;
+        int index = 0;
+
+        for (int i = 0; i < N; ++i) {
+            if (delta[i] > best) {
+                best = delta[i];
+                index = i;
+            }
+        }
+
+        if (best <= 0.001)
+            break;
+
+        // Lx = Lx - 2*x(index)*L(:,index), only nonzeros of row index change
+        double scale = 2.0 * x[index];
+        for (int e = S->row_start[index]; e < S->row_start[index + 1]; ++e)
+            Lx[S->col[e]] -= scale * S->val[e];
+        Lx[index] -= scale * S->diag[index];
+
+        x[index] *= -1;
+        cost += 4 * best;
+
+        for (int e = S->row_start[index]; e < S->row_start[index + 1]; ++e) {
+            int j = S->col[e];
+            delta[j] = S->diag[j] - x[j] * Lx[j];
+        }
+        delta[index] = S->diag[index] - x[index] * Lx[index];
+    }
+
+    free(Lx);
+    free(delta);
+
+    return cost;
+}
+
+
 /*
  * Given the current best solution, xbest, and a new solution, xnew, determines
  * the objective value of xnew, then replaces xbest with xnew if
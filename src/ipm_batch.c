@@ -0,0 +1,471 @@
+/* Batched interior-point method for basic SDP relaxations of the same size (params.ipm_batch) */
+
+/*
+ * Strong branching and dual fixing bound many subproblems of the same size n
+ * with the basic SDP relaxation. For small n a single ipm_mc_pk is dominated
+ * by the overhead of the BLAS and LAPACK calls. ipm_mc_pk_batch solves
+ * IPM_BATCH problems in lockstep with the iterations of ipm_mc_pk. Entry (i,j) of the matrix of problem b is stored at
+ * (i + j*n) * IPM_BATCH + b (interleaved layout), so the innermost loop of
+ * every kernel (Cholesky factorization, inverse, triangular solves, matrix
+ * product) runs over the problems of the batch and vectorizes.
+ *
+ * Every problem has its own step lengths. A problem that has converged (or
+ * whose bound proves pruning) takes steps of length 0 until all problems of
+ * the batch are done. Unused slots of a batch repeat the first problem and
+ * are done from the start. The workspace is allocated per call, so the
+ * batched IPM can be used by several threads.
+ *
+ * The kernels are plain loops: above IPM_BATCH_MAX_N the blocked BLAS and
+ * LAPACK routines of ipm_mc_pk are faster, and a batch with less than half
+ * of the slots used wastes more than it saves. Such problems are solved one
+ * by one with ipm_mc_pk_work.
+ */
+
+#include <math.h>
+
+#include "biqbin.h"
+
+#define IPM_BATCH_MATRICES 10   // L, X, Z, Zi, W, M, dX, dX1, tmp, tmp2
+#define IPM_BATCH_VECTORS 3     // y, dy, dy1
+
+/* entries (i,j) of all problems of the batch */
+#define E(A, i, j) ((A) + ((i) + (j) * n) * IPM_BATCH)
+
+
+/*
+ * Cholesky factorization A = W*W' of all problems (lower triangle of A is
+ * overwritten by W). fail[b] = 1 if A of problem b is not positive definite.
+ */
+static void batchCholesky(double *A, int n, int *fail) {
+
+    double d[IPM_BATCH];
+
+    for (int b = 0; b < IPM_BATCH; ++b)
+        fail[b] = 0;
+
+    for (int j = 0; j < n; ++j) {
+
+        for (int k = 0; k < j; ++k) {
+            const double *ajk = E(A, j, k);
+            for (int i = j; i < n; ++i) {
+                double *aij = E(A, i, j);
+                const double *aik = E(A, i, k);
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    aij[b] -= aik[b] * ajk[b];
+            }
+        }
+
+        // failed problems continue with pivot 1 so that no NaNs are produced
+        double *ajj = E(A, j, j);
+        for (int b = 0; b < IPM_BATCH; ++b) {
+            fail[b] |= !(ajj[b] > 0.0);
+            ajj[b] = sqrt((ajj[b] > 0.0) ? ajj[b] : 1.0);
+            d[b] = 1.0 / ajj[b];
+        }
+
+        for (int i = j + 1; i < n; ++i) {
+            double *aij = E(A, i, j);
+            for (int b = 0; b < IPM_BATCH; ++b)
+                aij[b] *= d[b];
+        }
+    }
+}
+
+
+/* Ai = inv(A) from the Cholesky factor W of A (lower triangle), T is workspace */
+static void batchInverse(const double *W, double *Ai, double *T, int n) {
+
+    double s[IPM_BATCH];
+
+    /* T = inv(W) (lower triangular) */
+    for (int j = 0; j < n; ++j) {
+
+        for (int b = 0; b < IPM_BATCH; ++b)
+            E(T, j, j)[b] = 1.0 / E(W, j, j)[b];
+
+        for (int i = j + 1; i < n; ++i) {
+            for (int b = 0; b < IPM_BATCH; ++b)
+                s[b] = 0.0;
+            for (int k = j; k < i; ++k) {
+                const double *wik = E(W, i, k);
+                const double *tkj = E(T, k, j);
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    s[b] += wik[b] * tkj[b];
+            }
+            const double *wii = E(W, i, i);
+            for (int b = 0; b < IPM_BATCH; ++b)
+                E(T, i, j)[b] = -s[b] / wii[b];
+        }
+    }
+
+    /* Ai = T'*T */
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i <= j; ++i) {
+            for (int b = 0; b < IPM_BATCH; ++b)
+                s[b] = 0.0;
+            for (int k = j; k < n; ++k) {
+                const double *tki = E(T, k, i);
+                const double *tkj = E(T, k, j);
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    s[b] += tki[b] * tkj[b];
+            }
+            for (int b = 0; b < IPM_BATCH; ++b)
+                E(Ai, i, j)[b] = E(Ai, j, i)[b] = s[b];
+        }
+    }
+}
+
+
+/* solve A*x = x with the Cholesky factor W of A (lower triangle), x(i) at x + i*IPM_BATCH */
+static void batchSolve(const double *W, double *x, int n) {
+
+    for (int i = 0; i < n; ++i) {
+        double *xi = x + i * IPM_BATCH;
+        for (int k = 0; k < i; ++k) {
+            const double *wik = E(W, i, k);
+            const double *xk = x + k * IPM_BATCH;
+            for (int b = 0; b < IPM_BATCH; ++b)
+                xi[b] -= wik[b] * xk[b];
+        }
+        const double *wii = E(W, i, i);
+        for (int b = 0; b < IPM_BATCH; ++b)
+            xi[b] /= wii[b];
+    }
+
+    for (int i = n - 1; i >= 0; --i) {
+        double *xi = x + i * IPM_BATCH;
+        for (int k = i + 1; k < n; ++k) {
+            const double *wki = E(W, k, i);
+            const double *xk = x + k * IPM_BATCH;
+            for (int b = 0; b < IPM_BATCH; ++b)
+                xi[b] -= wki[b] * xk[b];
+        }
+        const double *wii = E(W, i, i);
+        for (int b = 0; b < IPM_BATCH; ++b)
+            xi[b] /= wii[b];
+    }
+}
+
+
+/* C = A*B, two columns of C at a time */
+static void batchProduct(const double *restrict A, const double *restrict B, double *restrict C, int n) {
+
+    int size = n * n * IPM_BATCH;
+    for (int k = 0; k < size; ++k)
+        C[k] = 0.0;
+
+    int j = 0;
+    for (; j + 1 < n; j += 2) {
+        for (int k = 0; k < n; ++k) {
+            const double *bk0 = E(B, k, j);
+            const double *bk1 = E(B, k, j + 1);
+            for (int i = 0; i < n; ++i) {
+                const double *aik = E(A, i, k);
+                double *ci0 = E(C, i, j);
+                double *ci1 = E(C, i, j + 1);
+                for (int b = 0; b < IPM_BATCH; ++b) {
+                    ci0[b] += aik[b] * bk0[b];
+                    ci1[b] += aik[b] * bk1[b];
+                }
+            }
+        }
+    }
+    for (; j < n; ++j) {
+        for (int k = 0; k < n; ++k) {
+            const double *bkj = E(B, k, j);
+            for (int i = 0; i < n; ++i) {
+                const double *aik = E(A, i, k);
+                double *cij = E(C, i, j);
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    cij[b] += aik[b] * bkj[b];
+            }
+        }
+    }
+}
+
+
+/* A = (A + A')/2 */
+static void batchSymmetrize(double *A, int n) {
+
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < j; ++i) {
+            double *aij = E(A, i, j);
+            double *aji = E(A, j, i);
+            for (int b = 0; b < IPM_BATCH; ++b)
+                aij[b] = aji[b] = 0.5 * (aij[b] + aji[b]);
+        }
+    }
+}
+
+
+/*
+ * Longest step alpha[b] <= 1 (shrunk by 0.8) with A + alpha[b] * dA positive
+ * definite for the problems that are not done (alpha[b] = 0 for the others).
+ * dA is a matrix or, if diagonal, the vector of the diagonal entries.
+ */
+static void batchStepLength(const double *A, const double *dA, int diagonal, const int *active,
+                            double *alpha, double *T, int n) {
+
+    int pending[IPM_BATCH], fail[IPM_BATCH];
+    int size = n * n * IPM_BATCH;
+    int any = 0;
+
+    for (int b = 0; b < IPM_BATCH; ++b) {
+        alpha[b] = (active[b]) ? 1.0 : 0.0;
+        pending[b] = active[b];
+        any |= pending[b];
+    }
+
+    while (any) {
+
+        for (int k = 0; k < size; ++k)
+            T[k] = A[k];
+
+        if (diagonal) {
+            for (int j = 0; j < n; ++j)
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    E(T, j, j)[b] += alpha[b] * dA[j * IPM_BATCH + b];
+        }
+        else {
+            for (int k = 0; k < size; k += IPM_BATCH)
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    T[k + b] += alpha[b] * dA[k + b];
+        }
+
+        batchCholesky(T, n, fail);
+
+        any = 0;
+        for (int b = 0; b < IPM_BATCH; ++b) {
+            if (pending[b] && fail[b])
+                alpha[b] *= 0.8;
+            pending[b] &= fail[b];
+            any |= pending[b];
+        }
+    }
+
+    // stay away from boundary
+    for (int b = 0; b < IPM_BATCH; ++b) {
+        if (alpha[b] < 1.0)
+            alpha[b] *= 0.95;
+    }
+}
+
+
+/* ipm_mc_pk_bounded without branch_above for count <= IPM_BATCH problems of size n */
+static void ipmBatch(double *const *L, double *const *X, double *phi, int count, int n, double prune_below,
+                     double *work) {
+
+    int nn = n * n;
+    int size = nn * IPM_BATCH;
+
+    double *Lb = work;
+    double *Xb = Lb + size;
+    double *Z = Xb + size;
+    double *Zi = Z + size;
+    double *W = Zi + size;          // Cholesky factor of Z
+    double *M = W + size;           // Zi .* X and its Cholesky factor
+    double *dX = M + size;
+    double *dX1 = dX + size;
+    double *tmp = dX1 + size;
+    double *tmp2 = tmp + size;
+    double *y = work + IPM_BATCH_MATRICES * size;
+    double *dy = y + n * IPM_BATCH;
+    double *dy1 = dy + n * IPM_BATCH;
+
+    double psi[IPM_BATCH], mu[IPM_BATCH], gap[IPM_BATCH];
+    double alpha_p[IPM_BATCH], alpha_d[IPM_BATCH];
+    int active[IPM_BATCH], fail[IPM_BATCH];
+
+    /* interleave L, unused slots repeat the first problem */
+    for (int b = 0; b < IPM_BATCH; ++b) {
+        const double *Lsrc = L[(b < count) ? b : 0];
+        for (int k = 0; k < nn; ++k)
+            Lb[k * IPM_BATCH + b] = Lsrc[k];
+    }
+
+    /* y = 1.1 + sum(abs(L))', X = eye(n), Z = Diag(y) - L */
+    for (int j = 0; j < n; ++j) {
+        double *yj = y + j * IPM_BATCH;
+        for (int b = 0; b < IPM_BATCH; ++b)
+            yj[b] = 1.1;
+        for (int i = 0; i < n; ++i)
+            for (int b = 0; b < IPM_BATCH; ++b)
+                yj[b] += fabs(E(Lb, i, j)[b]);
+    }
+
+    for (int k = 0; k < size; ++k) {
+        Xb[k] = 0.0;
+        Z[k] = -Lb[k];
+    }
+    for (int j = 0; j < n; ++j) {
+        for (int b = 0; b < IPM_BATCH; ++b) {
+            E(Xb, j, j)[b] = 1.0;
+            E(Z, j, j)[b] += y[j * IPM_BATCH + b];
+        }
+    }
+
+    /* phi = e'y, psi = <L,X> = trace(L), mu = <Z,X> / (2n) = trace(Z) / (2n) */
+    for (int b = 0; b < IPM_BATCH; ++b) {
+        phi[b] = psi[b] = mu[b] = 0.0;
+        for (int j = 0; j < n; ++j) {
+            phi[b] += y[j * IPM_BATCH + b];
+            psi[b] += E(Lb, j, j)[b];
+            mu[b] += E(Z, j, j)[b];
+        }
+        mu[b] /= 2.0 * n;
+        gap[b] = fabs(phi[b] - psi[b]);
+        active[b] = (b < count) && gap[b] > 1e-2;
+    }
+
+    int any = 1;
+    while (any) {
+
+        /******** Zi = inv(Z) ********/
+        for (int k = 0; k < size; ++k)
+            W[k] = Z[k];
+        batchCholesky(W, n, fail);
+        for (int b = 0; b < IPM_BATCH; ++b) {
+            if (active[b] && fail[b]) {
+                fprintf(stderr, "%s: Problem with Cholesky factorization \
+                    (line: %d).\n", __func__, __LINE__);
+                MPI_Abort(MPI_COMM_WORLD,10);
+            }
+        }
+        batchInverse(W, Zi, tmp, n);
+
+        /******** predictor step: dy1 = (Zi .* X) \ (-e) ********/
+        for (int k = 0; k < size; ++k)
+            M[k] = Zi[k] * Xb[k];
+        batchCholesky(M, n, fail);
+        for (int b = 0; b < IPM_BATCH; ++b) {
+            if (active[b] && fail[b]) {
+                fprintf(stderr, "%s: predictor step: problem in solving linear system \
+                    (line: %d).\n", __func__, __LINE__);
+                MPI_Abort(MPI_COMM_WORLD,10);
+            }
+        }
+
+        for (int k = 0; k < n * IPM_BATCH; ++k)
+            dy1[k] = -1.0;
+        batchSolve(M, dy1, n);
+
+        /* dX1 = -Zi*diag(dy1)*X - X, symmetrized */
+        for (int j = 0; j < n; ++j)
+            for (int i = 0; i < n; ++i)
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    E(tmp, i, j)[b] = -dy1[i * IPM_BATCH + b] * E(Xb, i, j)[b];
+
+        batchProduct(Zi, tmp, dX1, n);
+        for (int k = 0; k < size; ++k)
+            dX1[k] -= Xb[k];
+        batchSymmetrize(dX1, n);
+
+        /******** corrector step: dy2 = M \ (mu*diag(Zi) - (Zi .* dX1)*dy1) ********/
+        for (int i = 0; i < n; ++i) {
+            double *dyi = dy + i * IPM_BATCH;
+            for (int b = 0; b < IPM_BATCH; ++b)
+                dyi[b] = mu[b] * E(Zi, i, i)[b];
+            for (int j = 0; j < n; ++j)
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    dyi[b] -= E(Zi, i, j)[b] * E(dX1, i, j)[b] * dy1[j * IPM_BATCH + b];
+        }
+        batchSolve(M, dy, n);
+
+        /* dX2 = mu*Zi - Zi*(diag(dy2)*X + diag(dy1)*dX1) */
+        for (int j = 0; j < n; ++j)
+            for (int i = 0; i < n; ++i)
+                for (int b = 0; b < IPM_BATCH; ++b)
+                    E(tmp2, i, j)[b] = -dy[i * IPM_BATCH + b] * E(Xb, i, j)[b]
+                                     - dy1[i * IPM_BATCH + b] * E(dX1, i, j)[b];
+
+        batchProduct(Zi, tmp2, dX, n);
+        for (int k = 0; k < size; k += IPM_BATCH)
+            for (int b = 0; b < IPM_BATCH; ++b)
+                dX[k + b] += mu[b] * Zi[k + b] + dX1[k + b];
+        batchSymmetrize(dX, n);
+
+        for (int k = 0; k < n * IPM_BATCH; ++k)
+            dy[k] += dy1[k];
+
+        /******** step lengths and update, dZ = Diag(dy) ********/
+        batchStepLength(Xb, dX, 0, active, alpha_p, tmp, n);
+        batchStepLength(Z, dy, 1, active, alpha_d, tmp, n);
+
+        for (int k = 0; k < size; k += IPM_BATCH)
+            for (int b = 0; b < IPM_BATCH; ++b)
+                Xb[k + b] += alpha_p[b] * dX[k + b];
+        for (int j = 0; j < n; ++j) {
+            for (int b = 0; b < IPM_BATCH; ++b) {
+                y[j * IPM_BATCH + b] += alpha_d[b] * dy[j * IPM_BATCH + b];
+                E(Z, j, j)[b] += alpha_d[b] * dy[j * IPM_BATCH + b];
+            }
+        }
+
+        /* mu = <Z,X> / (2n), phi = e'y, psi = <L,X> */
+        for (int b = 0; b < IPM_BATCH; ++b)
+            mu[b] = phi[b] = psi[b] = 0.0;
+        for (int k = 0; k < size; k += IPM_BATCH) {
+            for (int b = 0; b < IPM_BATCH; ++b) {
+                mu[b] += Z[k + b] * Xb[k + b];
+                psi[b] += Lb[k + b] * Xb[k + b];
+            }
+        }
+        for (int j = 0; j < n; ++j)
+            for (int b = 0; b < IPM_BATCH; ++b)
+                phi[b] += y[j * IPM_BATCH + b];
+
+        any = 0;
+        for (int b = 0; b < IPM_BATCH; ++b) {
+
+            mu[b] /= 2.0 * n;
+
+            /* speed up for long steps */
+            if (alpha_p[b] + alpha_d[b] > 1.6)
+                mu[b] *= 0.5;
+            if (alpha_p[b] + alpha_d[b] > 1.9)
+                mu[b] *= 0.2;
+
+            gap[b] = fabs(phi[b] - psi[b]);
+
+            // done: duality gap small or bound already proves pruning
+            if (gap[b] <= 1e-2 || phi[b] < prune_below)
+                active[b] = 0;
+            any |= active[b];
+        }
+
+        /* out of time: phi is a valid upper bound since Z stays positive definite */
+        if (timeLimitReached())
+            break;
+    }
+
+    for (int b = 0; b < count; ++b)
+        for (int k = 0; k < nn; ++k)
+            X[b][k] = Xb[k * IPM_BATCH + b];
+}
+
+
+/*
+ * Basic SDP relaxations of count problems L[b] of size n: phi[b] and X[b]
+ * as ipm_mc_pk_bounded(L[b], n, X[b], &phi[b], 0, prune_below, BIG_NUMBER).
+ */
+void ipm_mc_pk_batch(double *const *L, double *const *X, double *phi, int count, int n, double prune_below) {
+
+    int batch_size = (IPM_BATCH_MATRICES * n * n + IPM_BATCH_VECTORS * n) * IPM_BATCH;
+    int single_size = IPM_WORKSPACE_SIZE(n);
+
+    double *work;
+    alloc_vector(work, (batch_size > single_size) ? batch_size : single_size, double);
+
+    for (int first = 0; first < count; first += IPM_BATCH) {
+        int size = (count - first < IPM_BATCH) ? count - first : IPM_BATCH;
+
+        if (n <= IPM_BATCH_MAX_N && 2 * size >= IPM_BATCH)
+            ipmBatch(L + first, X + first, phi + first, size, n, prune_below, work);
+        else {
+            for (int b = first; b < first + size; ++b)
+                ipm_mc_pk_work(L[b], n, X[b], &phi[b], 0, prune_below, BIG_NUMBER, work);
+        }
+    }
+
+    free(work);
+}
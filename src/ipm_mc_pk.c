@@ -8,6 +8,7 @@
  * input:  L    ... objective matrix                                     *
  *         n    ... size of the problem                                  *
  *         print... print level                                          *
+ *         prune_below, branch_above ... see ipm_mc_pk_bounded           *
  * output: phi  ... optimal value of SDP (value of the dual problem)     *
  *         X    ... optimal primal matrix                                *
  *         y    ... optimal dual vector                                  *   
@@ -25,10 +26,77 @@
 /* NOTE: C uses row-major, but blas and lapack routines (written in Fortran)
  * use column-major --> be careful when multiplying non-symmetric matrices) */
 
+/*
+ * Workspace of the IPM: deep in the tree the subproblems are small and the
+ * IPM is called for every bundle evaluation, allocating the vectors and
+ * matrices per call costs as much as the factorizations. The workspace of
+ * the main thread is kept between calls and grown to the largest n. Other
+ * threads (strong branching probes) own their workspace and call
+ * ipm_mc_pk_work.
+ */
+static double *ipm_work = NULL;
+static int ipm_work_n = 0;
+
+
+static double *ipmWorkspace(int n) {
+
+    if (n > ipm_work_n) {
+        free(ipm_work);
+        alloc_vector(ipm_work, IPM_WORKSPACE_SIZE(n), double);
+        ipm_work_n = n;
+    }
+
+    return ipm_work;
+}
+
+
+void freeIPMWorkspace(void) {
+
+    free(ipm_work);
+    ipm_work = NULL;
+    ipm_work_n = 0;
+}
+
+
+/* tmp = -X*Diag(d) in column-major order (j-th row of X scaled by -d[j] in FORTRAN) */
+static void scaleRows(const double *X, const double *d, double *tmp, int n) {
+
+    for (int k = 0; k < n; ++k) {
+        const double *x = X + k * n;
+        double *t = tmp + k * n;
+        for (int j = 0; j < n; ++j)
+            t[j] = -d[j] * x[j];
+    }
+}
+
 void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
 
+    ipm_mc_pk_bounded(L, n, X, phi, print, -BIG_NUMBER, BIG_NUMBER);
+}
+
+
+/*
+ * ipm_mc_pk with early termination (params.ipm_early_stop): phi = e'y is an
+ * upper bound in every iteration (Z stays positive definite) and
+ * psi = <L,X> a lower bound of the optimal value (diag(X) = e).
+ *  - stops as soon as phi < prune_below (the node is pruned with phi),
+ *  - if psi > branch_above the node is not pruned by this bound and the
+ *    duality gap only needs to be below IPM_BRANCH_GAP.
+ */
+void ipm_mc_pk_bounded(double *L, int n, double *X, double *phi, int print, double prune_below, double branch_above) {
+
+    // main thread only: the workspace is shared by all calls
+    ipm_mc_pk_work(L, n, X, phi, print, prune_below, branch_above, ipmWorkspace(n));
+}
+
+
+/* ipm_mc_pk_bounded with workspace work of IPM_WORKSPACE_SIZE(n) doubles owned by the caller */
+void ipm_mc_pk_work(double *L, int n, double *X, double *phi, int print, double prune_below, double branch_above,
+                    double *work) {
+
     /* variables for blas and lapack routines */
     int inc = 1;
+    int incd = n + 1;           // stride of the diagonal of a matrix
     char up = 'U';              // for lapack take upper triangular part of matrix 
     char side = 'L';            // in matrix product AB, the left matrix is symmetric 
     int info;                   // test whether lapack function succeded
@@ -37,7 +105,7 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
 
     /* other variables */
     int i, j, k;                // loop iter
-    double *p, *p2, *p3;        // pointers in loops
+    double *p, *p2;             // pointers in loops
     double psi;                 // value of primal problem
     double mu;                  // ZX = mu * I (parametrized optimality condition)
     double alpha_p, alpha_d;    // step lengths
@@ -47,7 +115,7 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
     double *Z;                  // dual variable to X >= 0
 
     double *b;                  // vector of ones
-    double *dX, *dy, *dZ;       
+    double *dX, *dy;            // dZ = Diag(dy) is only applied to the diagonal
     double *Zi;                 // inv(Z)
     double *M;                  // M * dy = rhs
     double *dy1, *dX1;
@@ -57,11 +125,20 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
      * initial positive definite matrices X, Z and y *
      * primal, dual cost, gap                         *
      *************************************************/
-    alloc_vector(y, n, double);
-    alloc_matrix(Z, n, double);
-
     int nn = n*n;
 
+    Z = work;
+    dX = work + nn;
+    dX1 = work + 2 * nn;
+    tmp = work + 3 * nn;
+    tmp2 = work + 4 * nn;
+    Zi = work + 5 * nn;
+    M = work + 6 * nn;
+    y = work + IPM_WORK_MATRICES * nn;
+    b = y + n;
+    dy = b + n;
+    dy1 = dy + n;
+
     /* set y to zero vector */
     for (int i = 0; i < n; ++i)
         y[i] = 0.0;
@@ -76,7 +153,6 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
     }
 
     /* vector b of all ones */
-    alloc_vector(b, n, double);
     for (i = 0; i < n; ++i)
         b[i] = 1.0;
     
@@ -105,25 +181,12 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
         puts("*******************************************"); 
     }
 
-    /*  allocate space */
-    alloc_matrix(dX, n, double);
-    alloc_vector(dy, n, double);
-    alloc_matrix(dZ, n, double);
-
-    alloc_vector(dy1, n, double);
-    alloc_matrix(dX1, n, double);
-    alloc_matrix(tmp, n, double);
-    alloc_matrix(tmp2, n, double);
-
-    alloc_matrix(Zi, n, double);    
-    alloc_matrix(M, n, double);   
-
     /*************
      * main loop *
      *************/
     gap = fabs(*phi - psi);
     
-    for (i = 1; gap > 1e-2; ++i) {/* while duality gap too large */
+    for (i = 1; gap > ((psi > branch_above) ? IPM_BRANCH_GAP : 1e-2); ++i) {/* while duality gap too large */
         
         /******** compute inverse of Z ********/
         dcopy_(&nn,Z,&inc,Zi,&inc);         /* copy Z to Zi */   
@@ -178,10 +241,7 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
         /* 1. step: tmp = -diag(dy1)*X */
         /* = multiply j-th row of X by -dy1[j]        (FORTRAN) */
         /* = multiply j-th column of X by -dy[j]      (C)       */
-        p3 = tmp; 
-        for (j = 0, p = X, p2 = dy1; j < nn; ++j, ++p, ++p3) {
-            *p3 = -(p2[j%n]) * (*p);
-        }
+        scaleRows(X, dy1, tmp, n);
 
         /* 2. step: Zi * tmp */
         alpha = 1.0;
@@ -235,16 +295,10 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
         /* = multiply j-th row of X by -dy2[j]       (FORTRAN) */
         /* = multiply j-th column of X by -dy2[j]    (C)       */    
         /* NOTE: dy2 = dy */
-        p3 = tmp; 
-        for (j = 0, p = X, p2 = dy; j < nn; ++j, ++p, ++p3) {
-            *p3 = -(p2[j%n]) * (*p);
-        }
+        scaleRows(X, dy, tmp, n);
 
         /* 2. step: tmp2 = -diag(dy1)*dX1 */
-        p3 = tmp2; 
-        for (j = 0, p = dX1, p2 = dy1; j < nn; ++j, ++p, ++p3) {
-            *p3 = -(p2[j%n]) * (*p);
-        }
+        scaleRows(dX1, dy1, tmp2, n);
         
         /* tmp = tmp + tmp2 */
         alpha = 1.0;
@@ -271,8 +325,7 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
                 dX[k+n*j] = dX[j+n*k] = 0.5 * (dX[j+n*k] + dX[k+n*j]);
         }
 
-        /* dZ = Diag(dy) */
-        Diag(dZ,dy,n);
+        /* dZ = Diag(dy): only the diagonal of Z changes */
                 
 
         /*********** find step lengths alpha_p and alpha_d ***********/
@@ -298,7 +351,7 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
         info = 1;
         while (info != 0) {
             dcopy_(&nn,Z,&inc,tmp,&inc);            /* tmp = Z */
-            daxpy_(&nn,&alpha_d,dZ,&inc,tmp,&inc);  /* tmp = alpha_d * dZ + tmp */
+            daxpy_(&n,&alpha_d,dy,&inc,tmp,&incd);  /* tmp = alpha_d * dZ + tmp */
             dpotrf_(&up,&n,tmp,&n,&info);
 
             if (info != 0)
@@ -312,7 +365,7 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
         /******** update ********/
         daxpy_(&nn,&alpha_p,dX,&inc,X,&inc);        /* X = alpha_p * dX + X */    
         daxpy_(&n,&alpha_d,dy,&inc,y,&inc);         /* y = alpha_d * dy + y */
-        daxpy_(&nn,&alpha_d,dZ,&inc,Z,&inc);        /* Z = alpha_d * dZ + Z */
+        daxpy_(&n,&alpha_d,dy,&inc,Z,&incd);        /* Z = alpha_d * dZ + Z */
 
         /* mu = Z(:)'*X(:) / (2*n); */            
         mu = ddot_(&nn,Z,&inc,X,&inc) / (2.0 * n);   
@@ -338,22 +391,17 @@ void ipm_mc_pk(double *L, int n, double *X, double *phi, int print) {
         if (print)
             printf("%3d %11.2f %14.5f %14.5f \n",i,log10(gap),psi,*phi);
 
+        /* out of time: phi is a valid upper bound since Z stays positive definite */
+        if (timeLimitReached())
+            break;
+
+        /* bound already proves pruning */
+        if (*phi < prune_below)
+            break;
+
     } // end of main loop
 
     if (print)
         puts("*******************************************");
 
-    /************* free memory *************/
-    free(y);
-    free(Z);
-    free(b);    
-    free(dX);
-    free(dy);
-    free(dZ);
-    free(Zi);
-    free(M);
-    free(dy1);
-    free(dX1);
-    free(tmp);
-    free(tmp2);
 }
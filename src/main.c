@@ -8,11 +8,15 @@
 #define HEAP_SIZE 1000000
 extern Heap *heap;
 extern double diff;
+extern double granularity;
 
 extern BiqBinParameters params;
 extern double TIME;
 extern FILE *output;
 extern int max_depth;
+extern int num_pair_branchings;
+extern int num_strong_branchings;
+extern int num_strong_changes;
 
 int num_workers_used = 0;
 
@@ -54,15 +58,19 @@ int wrapped_main(int argc, char **argv) {
 
     // (2) for BabNode
     MPI_Datatype BabNodetype;
-    MPI_Datatype type2[5] = { MPI_INT, BabSolutiontype, MPI_DOUBLE, MPI_INT, MPI_INT };
-    int blocklen2[5] = { NMAX, 1, NMAX, 1, 1 };
-    MPI_Aint disp2[5];
+    MPI_Datatype type2[9] = { MPI_INT, BabSolutiontype, MPI_DOUBLE, MPI_INT, MPI_DOUBLE, MPI_DOUBLE, MPI_LONG_LONG, MPI_LONG_LONG, MPI_INT };
+    int blocklen2[9] = { NMAX, 1, NMAX, 1, 1, 1, 1, 1, 1 };
+    MPI_Aint disp2[9];
     disp2[0] = offsetof(BabNode, xfixed);
     disp2[1] = offsetof(BabNode, sol);
     disp2[2] = offsetof(BabNode, fracsol);
     disp2[3] = offsetof(BabNode, level);
     disp2[4] = offsetof(BabNode, upper_bound);
-    MPI_Type_create_struct(5, blocklen2, disp2, type2, &BabNodetype);
+    disp2[5] = offsetof(BabNode, prebound);
+    disp2[6] = offsetof(BabNode, id);
+    disp2[7] = offsetof(BabNode, parent_id);
+    disp2[8] = offsetof(BabNode, branch_var);
+    MPI_Type_create_struct(9, blocklen2, disp2, type2, &BabNodetype);
     MPI_Type_commit(&BabNodetype);
     /***********************************/
 
@@ -132,21 +140,27 @@ int wrapped_main(int argc, char **argv) {
         /***** branch root node and send to workers *****/
         node = Bab_PQPop();
 
-        // Determine the variable x[ic] to branch on
-        int ic = getBranchingVariable(node);
+        // fix and link variables of the root with probes on all processes
+        if (params.root_probing > 0) {
+            rootProbing(node, rank, BabNodetype);
 
-        // send two nodes to workers 1 and 2
+            if (Bab_LBGet() + granularity >= node->upper_bound) {
+                free(node);
+                goto ROOT_PRUNED;
+            }
+        }
+
+        // Split root node into two children
+        BabNode *children[2];
         BabNode *child_node;
+        createChildren(node, children);
+
+        // send two nodes to workers 1 and 2
         int worker;
         
         for (int xic = 0; xic <= 1; ++xic) { 
 
-            // Create a new child node from the parent node
-            child_node = newNode(node);
-
-            // split on node ic
-            child_node->xfixed[ic] = 1;
-            child_node->sol.X[ic] = xic;
+            child_node = children[xic];
 
             // increment the number of explored nodes
             Bab_incEvalNodes();
@@ -180,6 +194,8 @@ int wrapped_main(int argc, char **argv) {
         } while ( numbFreeWorkers != numbWorkers - 1 );
         /*************************************************/
 
+        ROOT_PRUNED:
+
         // send over messages to the workers
         over = 1;
         for(int i = 1; i < numbWorkers; ++i) {
@@ -206,6 +222,10 @@ int wrapped_main(int argc, char **argv) {
 	// update lower bound
 	BabSolution solx;
 	Bab_LBUpd(g_lowerBound, &solx);
+
+        // probes of the root node
+        if (params.root_probing > 0)
+            rootProbing(NULL, rank, BabNodetype);
         
         /************* MAIN LOOP for worker **************/
         do {
@@ -225,12 +245,13 @@ int wrapped_main(int argc, char **argv) {
 		        Bab_LBUpd(g_lowerBound, &solx);
 
                 // start local queue
+                setNodePriority(node);
                 Bab_PQInsert(node);
 
                 while(!isPQEmpty()){
 
                     // check if time limit reached
-                    if (params.time_limit > 0 && (MPI_Wtime() - TIME) > params.time_limit) {
+                    if (timeLimitReached()) {
                         break;
                     }
 
@@ -252,6 +273,12 @@ int wrapped_main(int argc, char **argv) {
     int global_max_depth;
     MPI_Reduce(&max_depth, &global_max_depth, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
     max_depth = global_max_depth;
+    int counts[3] = { num_pair_branchings, num_strong_branchings, num_strong_changes };
+    int global_counts[3];
+    MPI_Reduce(counts, global_counts, 3, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    num_pair_branchings = global_counts[0];
+    num_strong_branchings = global_counts[1];
+    num_strong_changes = global_counts[2];
     if (rank == 0) {
         #ifndef PURE_C
         copy_solution();
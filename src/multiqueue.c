@@ -0,0 +1,217 @@
+/* MultiQueue: relaxed concurrent priority queue for B&B nodes */
+/* Used when several threads of one rank share the local B&B nodes */
+
+/*
+ * The queue consists of c * (number of threads) ordinary max-heaps (heap.c),
+ * each protected by its own lock. Insert places a node into a random heap,
+ * pop looks at the tops of two random heaps and removes the better one
+ * (two-choice popping). The popped node is therefore not always the global
+ * best, but it is among the best ones with high probability, and threads
+ * almost never wait on each other.
+ *
+ * Nodes are ordered by compare_Nodes (heap.c), the priorities of the tops
+ * are read without taking the lock (atomic loads of the cached value);
+ * a stale value only affects which of the two heaps is chosen.
+ */
+
+#include "biqbin.h"
+
+static inline double load_top(SubQueue *q) {
+    double top;
+    __atomic_load(&q->top, &top, __ATOMIC_RELAXED);
+    return top;
+}
+
+static inline void store_top(SubQueue *q) {
+    double top = (q->heap->used > 0) ? q->heap->data[0]->priority : -BIG_NUMBER;
+    __atomic_store(&q->top, &top, __ATOMIC_RELAXED);
+}
+
+
+MultiQueue *MQ_Init(int num_threads, int queues_per_thread, int size) {
+
+    MultiQueue *mq;
+    alloc(mq, MultiQueue);
+
+    mq->num_queues = num_threads * queues_per_thread;
+    if (mq->num_queues < 2)
+        mq->num_queues = 2;
+
+    // aligned_alloc instead of calloc so that every heap is on its own cache line
+    mq->queues = aligned_alloc(64, mq->num_queues * sizeof(SubQueue));
+    if (mq->queues == NULL) {
+        fprintf(stderr, "Error: Not enough memory for MultiQueue.\n");
+        abort_alloc_fail(10);
+    }
+
+    for (int i = 0; i < mq->num_queues; ++i) {
+        pthread_mutex_init(&mq->queues[i].lock, NULL);
+        mq->queues[i].heap = Init_Heap(size);
+        mq->queues[i].top = -BIG_NUMBER;
+    }
+
+    return mq;
+}
+
+
+void MQ_Free(MultiQueue *mq) {
+
+    for (int i = 0; i < mq->num_queues; ++i) {
+        Heap *h = mq->queues[i].heap;
+        for (int j = 0; j < h->used; ++j)
+            free(h->data[j]);
+        free(h->data);
+        free(h);
+        pthread_mutex_destroy(&mq->queues[i].lock);
+    }
+
+    free(mq->queues);
+    free(mq);
+}
+
+
+void MQ_Insert(MultiQueue *mq, BabNode *node, unsigned int *seed) {
+
+    SubQueue *q;
+
+    // try random heaps until one is not locked by another thread
+    do {
+        q = &mq->queues[rand_r(seed) % mq->num_queues];
+    } while (pthread_mutex_trylock(&q->lock) != 0);
+
+    Heap_Insert(q->heap, node);
+    store_top(q);
+
+    pthread_mutex_unlock(&q->lock);
+}
+
+
+BabNode *MQ_PopApprox(MultiQueue *mq, unsigned int *seed) {
+
+    SubQueue *q;
+    BabNode *node;
+
+    while (1) {
+
+        SubQueue *q1 = &mq->queues[rand_r(seed) % mq->num_queues];
+        SubQueue *q2 = &mq->queues[rand_r(seed) % mq->num_queues];
+        q = (load_top(q1) >= load_top(q2)) ? q1 : q2;
+
+        if (load_top(q) == -BIG_NUMBER) {
+            // both sampled heaps empty: scan for any nonempty heap before giving up
+            q = NULL;
+            for (int i = 0; i < mq->num_queues; ++i) {
+                if (load_top(&mq->queues[i]) != -BIG_NUMBER) {
+                    q = &mq->queues[i];
+                    break;
+                }
+            }
+            if (q == NULL)
+                return NULL;
+        }
+
+        if (pthread_mutex_trylock(&q->lock) != 0)
+            continue;
+
+        // heap may have been emptied between reading top and locking
+        if (q->heap->used == 0) {
+            pthread_mutex_unlock(&q->lock);
+            continue;
+        }
+
+        node = Heap_Pop(q->heap);
+        store_top(q);
+        pthread_mutex_unlock(&q->lock);
+
+        return node;
+    }
+}
+
+
+/*
+ * Removes the k best nodes over all heaps and stores them in nodes.
+ * Used for donations to other ranks, so the selection is exact: all heaps
+ * are locked (in index order to avoid deadlocks) while extracting.
+ * Returns the number of extracted nodes.
+ */
+int MQ_ExtractBulk(MultiQueue *mq, BabNode **nodes, int k) {
+
+    int count = 0;
+
+    for (int i = 0; i < mq->num_queues; ++i)
+        pthread_mutex_lock(&mq->queues[i].lock);
+
+    while (count < k) {
+
+        int best = -1;
+
+        for (int i = 0; i < mq->num_queues; ++i) {
+            Heap *h = mq->queues[i].heap;
+            if (h->used > 0 && (best == -1 || compare_Nodes(h->data[0], mq->queues[best].heap->data[0]) > 0))
+                best = i;
+        }
+
+        if (best == -1)
+            break;
+
+        nodes[count++] = Heap_Pop(mq->queues[best].heap);
+        store_top(&mq->queues[best]);
+    }
+
+    for (int i = mq->num_queues - 1; i >= 0; --i)
+        pthread_mutex_unlock(&mq->queues[i].lock);
+
+    return count;
+}
+
+
+/*
+ * Frees every node whose upper bound is below threshold (cannot contain a
+ * better solution after the lower bound improved).
+ * Returns the number of pruned nodes.
+ */
+int MQ_PruneBelow(MultiQueue *mq, double threshold) {
+
+    int pruned = 0;
+
+    for (int i = 0; i < mq->num_queues; ++i) {
+
+        SubQueue *q = &mq->queues[i];
+        pthread_mutex_lock(&q->lock);
+
+        Heap *h = q->heap;
+        int next = 0;
+
+        for (int j = 0; j < h->used; ++j) {
+            if (h->data[j]->upper_bound < threshold) {
+                free(h->data[j]);
+                ++pruned;
+            }
+            else {
+                h->data[next++] = h->data[j];
+            }
+        }
+
+        for (int j = next; j < h->used; ++j)
+            h->data[j] = NULL;
+
+        h->used = next;
+        Heap_Rebuild(h);
+        store_top(q);
+
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    return pruned;
+}
+
+
+int MQ_Size(MultiQueue *mq) {
+
+    int size = 0;
+
+    for (int i = 0; i < mq->num_queues; ++i)
+        size += __atomic_load_n(&mq->queues[i].heap->used, __ATOMIC_RELAXED);
+
+    return size;
+}
@@ -0,0 +1,123 @@
+/* Pipelined node evaluation (params.pipeline) */
+
+/*
+ * In the cutting plane loop of SDPbound the heuristic of round k runs in a
+ * helper thread on a copy of the primal matrix X of round k, while the main
+ * thread separates the cuts of round k+1 on the same X and runs the bundle
+ * iterations of round k+1. The solution of the helper is merged
+ * (updateSolution) after these bundle iterations and when the loop ends.
+ *
+ * Separation stays in the main thread: the bundle iterations of a round
+ * need its cuts, so a separation on an older X would only delay them.
+ *
+ * The helper only reads the problem data and the node and works on its own
+ * copies of X and Z, all MPI communication stays in the main thread. The
+ * heuristic of the Python interface runs in the interpreter and is not
+ * pipelined.
+ */
+
+#include <time.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern double *X;
+extern Problem *SP;
+extern EvalStats eval_stats;
+
+typedef struct HeuristicTask
+{
+    pthread_t thread;
+    int running;
+    Problem *SP;
+    Problem *PP;
+    BabNode *node;
+    double *X;              // copy of X when the heuristic was started
+    double *Z;              // workspace of the heuristic
+    int x[NMAX];            // solution
+    double time;            // seconds spent in the heuristic
+} HeuristicTask;
+
+static HeuristicTask task;
+
+
+void initPipeline(void) {
+
+#ifdef PURE_C
+    if (params.pipeline) {
+        alloc_matrix(task.X, SP->n, double);
+        alloc_matrix(task.Z, SP->n, double);
+    }
+#endif
+}
+
+
+void freePipeline(void) {
+
+    free(task.X);
+    free(task.Z);
+}
+
+
+/* wall clock of the helper thread (MPI_Wtime is reserved for the main thread) */
+static double threadTime(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+static void *heuristicThread(void *arg) {
+
+    HeuristicTask *t = arg;
+    double start = threadTime();
+
+    runHeuristicOnMatrix(t->SP->L, t->SP->n, t->PP->L, t->PP->n, t->node->xfixed, t->node->sol.X, t->X, t->Z, t->x);
+    resolveLinkedVariables(t->node->xfixed, t->node->sol.X, t->x);
+
+    t->time = threadTime() - start;
+    return NULL;
+}
+
+
+/* start the heuristic of node on the current X in the helper thread, returns 0 if not pipelined */
+int Pipeline_StartHeuristic(Problem *SP, Problem *PP, BabNode *node) {
+
+    if (task.X == NULL || task.running)
+        return 0;
+
+    int nn = PP->n * PP->n;
+    int inc = 1;
+    dcopy_(&nn, X, &inc, task.X, &inc);
+
+    for (int i = 0; i < BabPbSize; ++i)
+        task.x[i] = (node->xfixed[i] == 1) ? node->sol.X[i] : 0;
+
+    task.SP = SP;
+    task.PP = PP;
+    task.node = node;
+
+    if (pthread_create(&task.thread, NULL, heuristicThread, &task) != 0)
+        return 0;
+
+    task.running = 1;
+    return 1;
+}
+
+
+/* wait for the helper thread and merge its solution, returns 0 if no heuristic was running */
+int Pipeline_FinishHeuristic(void) {
+
+    if (!task.running)
+        return 0;
+
+    pthread_join(task.thread, NULL);
+    task.running = 0;
+
+    updateSolution(task.x);
+    eval_stats.time_heuristic += task.time;
+
+    return 1;
+}
@@ -0,0 +1,152 @@
+/* Reliability pseudo-cost branching (branchingStrategy = PSEUDO_COST) */
+
+/*
+ * The pseudo-cost of variable i and value v is the average decrease of the
+ * upper bound observed when x[i] was fixed to v: from evaluated children and
+ * from strong branching probes. Observations of all processes are combined
+ * through the shared statistics (shared_stats.c).
+ *
+ * A variable is reliable if both of its pseudo-costs are based on at least
+ * params.pc_reliability observations. Up to params.sb_candidates of the most
+ * fractional unreliable variables are probed with strong branching, then the
+ * variable with the best score of the estimated decreases is chosen.
+ */
+
+#include <math.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+
+/* layout in shared statistics: sum[v][i] and count[v][i] for v = 0, 1 */
+static int pc_offset = -1;
+
+#define PC_SUM(v, i)   (pc_offset + (v) * BabPbSize + (i))
+#define PC_COUNT(v, i) (pc_offset + (2 + (v)) * BabPbSize + (i))
+
+
+void initPseudoCosts(void) {
+
+    // pseudo-costs are also features of the learned scorer
+    if (params.branchingStrategy == PSEUDO_COST || params.branchingStrategy == LEARNED_SCORE)
+        pc_offset = SharedStats_Register(4 * BabPbSize);
+}
+
+
+/* record decrease of the bound when x[var] was fixed to value */
+void recordPseudoCost(int var, int value, double parent_bound, double bound) {
+
+    if (pc_offset < 0 || var < 0 || parent_bound >= BIG_NUMBER)
+        return;
+
+    // bounds of children can be slightly larger due to inexact SDP solutions
+    double drop = parent_bound - bound;
+    SharedStats_Add(PC_SUM(value, var), (drop > 0.0) ? drop : 0.0);
+    SharedStats_Add(PC_COUNT(value, var), 1.0);
+}
+
+
+/* average decrease est[v] of the bound when x[var] was fixed to v, 0 without history */
+void pseudoCostEstimates(int var, double est[2], double *count) {
+
+    *count = 0.0;
+    est[0] = est[1] = 0.0;
+
+    if (pc_offset < 0)
+        return;
+
+    const double *stats = SharedStats_Get(0);
+    for (int v = 0; v <= 1; ++v) {
+        if (stats[PC_COUNT(v, var)] > 0.0)
+            est[v] = stats[PC_SUM(v, var)] / stats[PC_COUNT(v, var)];
+    }
+
+    *count = (stats[PC_COUNT(0, var)] < stats[PC_COUNT(1, var)]) ? stats[PC_COUNT(0, var)] : stats[PC_COUNT(1, var)];
+}
+
+
+/* record pseudo-cost observation of an evaluated node */
+void recordNodePseudoCost(BabNode *node, double parent_bound) {
+
+    // children of pair branching have no pseudo-costs
+    if (node->branch_var >= 0 && node->xfixed[node->branch_var] == 1)
+        recordPseudoCost(node->branch_var, node->sol.X[node->branch_var], parent_bound, node->upper_bound);
+}
+
+
+int pseudoCostBranchingVariable(BabNode *node) {
+
+    const double *stats = SharedStats_Get(0);
+    int num_free = 0;
+    int unreliable[BabPbSize];
+    int num_unreliable = 0;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (node->xfixed[i])
+            continue;
+        ++num_free;
+        if (stats[PC_COUNT(0, i)] < params.pc_reliability || stats[PC_COUNT(1, i)] < params.pc_reliability)
+            unreliable[num_unreliable++] = i;
+    }
+
+    if (num_free == 0)
+        return -1;
+
+    /* strong branching probes for the most fractional unreliable variables */
+    if (num_unreliable > 0 && params.sb_candidates > 0) {
+
+        int candidates[params.sb_candidates];
+        int num_candidates = selectFractionalCandidates(node, unreliable, num_unreliable,
+                                                        params.sb_candidates, candidates);
+        double bounds[2 * num_candidates];
+
+        strongBranchingProbe(node, candidates, num_candidates, bounds);
+
+        for (int c = 0; c < num_candidates; ++c) {
+            recordPseudoCost(candidates[c], 0, node->upper_bound, bounds[2 * c]);
+            recordPseudoCost(candidates[c], 1, node->upper_bound, bounds[2 * c + 1]);
+        }
+    }
+
+    /* average pseudo-costs over all variables for variables without history */
+    double avg[2];
+    for (int v = 0; v <= 1; ++v) {
+        double sum = 0.0, count = 0.0;
+        for (int i = 0; i < BabPbSize; ++i) {
+            sum += stats[PC_SUM(v, i)];
+            count += stats[PC_COUNT(v, i)];
+        }
+        avg[v] = (count > 0.0) ? sum / count : 1.0;
+    }
+
+    /* best score, ties are broken by fractionality */
+    int ic = -1;
+    double best_score = -BIG_NUMBER;
+    double best_frac = BIG_NUMBER;
+
+    for (int i = 0; i < BabPbSize; ++i) {
+
+        if (node->xfixed[i])
+            continue;
+
+        double est[2];
+        for (int v = 0; v <= 1; ++v) {
+            double count = stats[PC_COUNT(v, i)];
+            est[v] = (count > 0.0) ? stats[PC_SUM(v, i)] / count : avg[v];
+            est[v] = (est[v] > 1e-6) ? est[v] : 1e-6;
+        }
+
+        double score = (params.sb_score == SB_SCORE_MIN) ?
+                       ((est[0] < est[1]) ? est[0] : est[1]) : est[0] * est[1];
+        double frac = fabs(0.5 - node->fracsol[i]);
+
+        if (score > best_score || (score == best_score && frac < best_frac)) {
+            best_score = score;
+            best_frac = frac;
+            ic = i;
+        }
+    }
+
+    return ic;
+}
@@ -0,0 +1,211 @@
+/* Probing of the root node on all processes (params.root_probing) */
+
+/*
+ * Before the root is branched, both children of the params.root_probing
+ * least fractional variables are evaluated, the probes are distributed over
+ * all processes (the workers are idle at this point). Probes are evaluated
+ * like nodes of workers, i.e. with params.use_diff they give up early.
+ *
+ * With the best lower bound LB found by all processes:
+ *  - if the child x[i] = v has bound < LB + 1, x[i] is fixed to 1 - v,
+ *    if both children have such a bound, the larger one is a bound of the
+ *    root and the root is pruned,
+ *  - otherwise variables that dual fixing (dual_fixing.c) fixes in both
+ *    children give implications: x[j] = w in both children fixes x[j] = w,
+ *    x[j] = w if x[i] = 0 and x[j] = 1 - w if x[i] = 1 links x[j] to x[i]
+ *    (x[j] = x[i] XOR w, see pair branching).
+ * Fixings and links are applied to the root, so that every later node of
+ * the search inherits them.
+ */
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern BabSolution *BabSol;
+extern Problem *SP;
+extern Problem *PP;
+extern double granularity;
+
+
+/* every process gets the best lower bound and solution found so far */
+static void shareLowerBound(int rank) {
+
+    struct { double value; int rank; } local, best;
+
+    local.value = Bab_LBGet();
+    local.rank = rank;
+    MPI_Allreduce(&local, &best, 1, MPI_DOUBLE_INT, MPI_MAXLOC, MPI_COMM_WORLD);
+
+    BabSolution solx = *BabSol;
+    MPI_Bcast(solx.X, BabPbSize, MPI_INT, best.rank, MPI_COMM_WORLD);
+    Bab_LBUpd(best.value, &solx);
+}
+
+
+/*
+ * Evaluate probe t = 2*c + v (x[candidates[c]] = v) of root.
+ * bound[t] is its upper bound, implied[t*BabPbSize + j] the value of x[j]
+ * fixed by dual fixing in the probe (-1 if not fixed).
+ */
+static void evaluateProbe(const BabNode *root, const int *candidates, int t, double *bound, int *implied) {
+
+    BabNode probe = *root;
+    int var = candidates[t / 2];
+
+    probe.xfixed[var] = 1;
+    probe.sol.X[var] = t % 2;
+    probe.level = root->level + 1;
+
+    // rank != 0: probes do not change diff of the root
+    bound[t] = Evaluate(&probe, SP, PP, 1);
+
+    if (bound[t] >= Bab_LBGet() + granularity)
+        dualFixing(&probe, params.root_probing);
+
+    for (int j = 0; j < BabPbSize; ++j)
+        implied[t * BabPbSize + j] = (probe.xfixed[j] == 1 && !root->xfixed[j] && j != var) ? probe.sol.X[j] : -1;
+}
+
+
+/* fix x[j] = value in root if x[j] is free, returns 1 if fixed */
+static int fixInRoot(BabNode *root, int j, int value) {
+
+    if (root->xfixed[j])
+        return 0;
+
+    root->xfixed[j] = 1;
+    root->sol.X[j] = value;
+
+    return 1;
+}
+
+
+/*
+ * Collective: called by all processes, root is only used on the master.
+ * On the master, fixings and links are applied to root and root is evaluated
+ * again (restores PP, X and the cuts of the root). Returns the number of fixed and linked variables.
+ */
+int rootProbing(BabNode *root, int rank, MPI_Datatype BabNodetype) {
+
+    int num_procs;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+    BabNode node;
+    if (rank == 0)
+        node = *root;
+    MPI_Bcast(&node, 1, BabNodetype, 0, MPI_COMM_WORLD);
+
+    /* same candidates on every process */
+    int candidates[params.root_probing];
+    int num_candidates = selectIntegralCandidates(&node, params.root_probing, candidates);
+    int num_probes = 2 * num_candidates;
+
+    double *bound, *all_bound = NULL;
+    int *implied, *all_implied = NULL;
+    alloc_vector(bound, num_probes, double);
+    alloc_vector(implied, num_probes * BabPbSize, int);
+
+    for (int t = 0; t < num_probes; ++t) {
+        bound[t] = -BIG_NUMBER;
+        for (int j = 0; j < BabPbSize; ++j)
+            implied[t * BabPbSize + j] = -1;
+    }
+
+    for (int t = rank; t < num_probes && !timeLimitReached(); t += num_procs)
+        evaluateProbe(&node, candidates, t, bound, implied);
+
+    /* collect results on the master */
+    if (rank == 0) {
+        alloc_vector(all_bound, num_probes, double);
+        alloc_vector(all_implied, num_probes * BabPbSize, int);
+    }
+    MPI_Reduce(bound, all_bound, num_probes, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(implied, all_implied, num_probes * BabPbSize, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+    free(bound);
+    free(implied);
+
+    shareLowerBound(rank);
+
+    if (rank != 0)
+        return 0;
+
+    /* apply fixings and implications to the root */
+    int num_fixed = 0;
+    int num_linked = 0;
+    int root_pruned = 0;
+    double LB = Bab_LBGet();
+
+    for (int c = 0; c < num_candidates; ++c) {
+
+        int var = candidates[c];
+        const double *b = all_bound + 2 * c;
+        const int *imp0 = all_implied + 2 * c * BabPbSize;
+        const int *imp1 = imp0 + BabPbSize;
+
+        // probes stopped by the time limit are not used
+        if (b[0] == -BIG_NUMBER || b[1] == -BIG_NUMBER)
+            continue;
+
+        int pruned0 = (b[0] < LB + granularity);
+        int pruned1 = (b[1] < LB + granularity);
+
+        // both pruned: every solution of the root is in one of the children
+        if (pruned0 && pruned1) {
+            double bound_children = (b[0] > b[1]) ? b[0] : b[1];
+            if (bound_children < root->upper_bound)
+                root->upper_bound = bound_children;
+            root_pruned = 1;
+            break;
+        }
+
+        if (pruned0 || pruned1) {
+            int value = pruned0 ? 1 : 0;
+            const int *imp = pruned0 ? imp1 : imp0;
+
+            num_fixed += fixInRoot(root, var, value);
+            for (int j = 0; j < BabPbSize; ++j) {
+                if (imp[j] >= 0)
+                    num_fixed += fixInRoot(root, j, imp[j]);
+            }
+            continue;
+        }
+
+        for (int j = 0; j < BabPbSize; ++j) {
+
+            if (imp0[j] < 0 || imp1[j] < 0 || root->xfixed[j])
+                continue;
+
+            if (imp0[j] == imp1[j]) {
+                num_fixed += fixInRoot(root, j, imp0[j]);
+            }
+            else if (!root->xfixed[var]) {
+                // x[j] = x[var] XOR imp0[j]
+                root->xfixed[j] = LINKED;
+                root->sol.X[j] = 2 * var + imp0[j];
+                ++num_linked;
+            }
+        }
+    }
+
+    free(all_bound);
+    free(all_implied);
+
+    if (root_pruned) {
+        printf("Root probing: root pruned, bound %.2f\n", root->upper_bound);
+        return num_fixed + num_linked;
+    }
+
+    printf("Root probing: %d variables fixed, %d variables linked\n", num_fixed, num_linked);
+
+    // the probes of the master overwrote PP, X and the cuts: the root is
+    // evaluated again, also without fixings, before it is branched
+    // (rank != 0: diff was already sent to the workers)
+    if (num_probes > 0) {
+        double bound_root = Evaluate(root, SP, PP, 1);
+        if (bound_root < root->upper_bound)
+            root->upper_bound = bound_root;
+    }
+
+    return num_fixed + num_linked;
+}
@@ -0,0 +1,239 @@
+/* Learned scores for branching and node selection */
+
+/*
+ * Linear models trained offline (e.g. on trees logged with params.trace) are
+ * read from the file <parameter file>.model, one model per line:
+ *
+ *   branch linear b w_1 ... w_7     (branchingStrategy = LEARNED_SCORE)
+ *   node linear b w_1 w_2 w_3       (node_selection = 1)
+ *
+ * Lines starting with # are comments. The score is b + sum_k w_k * feature_k.
+ *
+ * Branching candidates (free variable i of the evaluated node):
+ *   1  fractionality 1 - 2|fracsol[i] - 0.5|
+ *   2  mean |X_ij| over the other free variables j of the subproblem
+ *   3  max |X_ij| over the other free variables j
+ *   4  number of neighbours of i among the free variables / number of free variables
+ *   5  pseudo-cost of x[i] = 0 (average bound decrease, 0 without history)
+ *   6  pseudo-cost of x[i] = 1
+ *   7  log(1 + number of pseudo-cost observations of the less observed side)
+ * The candidate with the largest score is branched on.
+ *
+ * Open nodes:
+ *   1  depth
+ *   2  gap upper_bound - lower bound
+ *   3  number of free variables
+ * The node with the largest score is evaluated first. Since the model is
+ * linear, the lower bound shifts the scores of all nodes by the same amount:
+ * the score without it is computed once when a node is queued
+ * (setNodePriority) and the order of the heap stays valid when it improves.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern Problem *SP;
+extern Problem *PP;
+extern double *X;
+
+#define SCORER_BRANCH_FEATURES 7
+#define SCORER_NODE_FEATURES 3
+
+static int branch_loaded = 0;
+static double branch_weights[SCORER_BRANCH_FEATURES + 1];     // bias first
+static int node_loaded = 0;
+static double node_weights[SCORER_NODE_FEATURES + 1];
+
+/* X column statistics of the free variables, stored before X is overwritten */
+static double column_mean[NMAX];
+static double column_max[NMAX];
+
+
+/* read "linear b w_1 ... w_size" after the model name, returns 1 on success */
+static int readLinearModel(const char *s, double *weights, int size) {
+
+    char kind[16];
+    int used;
+
+    if (sscanf(s, "%15s%n", kind, &used) != 1 || strcmp(kind, "linear") != 0)
+        return 0;
+    s += used;
+
+    for (int k = 0; k <= size; ++k) {
+        if (sscanf(s, "%lf%n", &weights[k], &used) != 1)
+            return 0;
+        s += used;
+    }
+
+    return 1;
+}
+
+
+/* load the models used by params from <parameter file>.model, returns 1 on error */
+int loadScorer(const char *param_path, int rank) {
+
+    int need_branch = (params.branchingStrategy == LEARNED_SCORE);
+    int need_node = (params.node_selection == 1);
+
+    if (!need_branch && !need_node)
+        return 0;
+
+    char path[strlen(param_path) + 7];
+    sprintf(path, "%s.model", param_path);
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        if (rank == 0)
+            fprintf(stderr, "Error: model file %s not found.\n", path);
+        return 1;
+    }
+
+    char s[1024];
+    char name[16];
+    int used;
+    int error = 0;
+
+    while (fgets(s, sizeof(s), file) != NULL) {
+
+        if (s[0] == '#' || sscanf(s, "%15s%n", name, &used) != 1)
+            continue;
+
+        if (strcmp(name, "branch") == 0) {
+            branch_loaded = readLinearModel(s + used, branch_weights, SCORER_BRANCH_FEATURES);
+            error |= !branch_loaded;
+        }
+        else if (strcmp(name, "node") == 0) {
+            node_loaded = readLinearModel(s + used, node_weights, SCORER_NODE_FEATURES);
+            error |= !node_loaded;
+        }
+    }
+    fclose(file);
+
+    if (error || (need_branch && !branch_loaded) || (need_node && !node_loaded)) {
+        if (rank == 0)
+            fprintf(stderr, "Error: model file %s needs the lines\n"
+                            "  branch linear b w_1 ... w_%d   (branchingStrategy = %d)\n"
+                            "  node linear b w_1 ... w_%d     (node_selection = 1)\n",
+                    path, SCORER_BRANCH_FEATURES, LEARNED_SCORE, SCORER_NODE_FEATURES);
+        return 1;
+    }
+
+    // models in the file that params do not ask for are not used
+    branch_loaded = need_branch;
+    node_loaded = need_node;
+
+    return 0;
+}
+
+
+/*
+ * Store the X column statistics of the free variables of node, must be
+ * called directly after the node was evaluated (uses X and PP).
+ */
+void Scorer_StoreColumnStats(const BabNode *node) {
+
+    if (!branch_loaded)
+        return;
+
+    int n = PP->n;
+    int index = 0;
+
+    // PP is not the subproblem of node (e.g. bounded by components): no statistics
+    if (n - 1 != BabPbSize - countFixedVariables((BabNode *) node)) {
+        for (int i = 0; i < BabPbSize; ++i)
+            column_mean[i] = column_max[i] = 0.0;
+        return;
+    }
+
+    // last vertex of the subproblem is not a variable
+    for (int i = 0; i < BabPbSize; ++i) {
+
+        if (node->xfixed[i])
+            continue;
+
+        double sum = 0.0, max = 0.0;
+        for (int b = 0; b < n - 1; ++b) {
+            if (b == index)
+                continue;
+            double entry = fabs(X[b + index * n]);
+            sum += entry;
+            max = (entry > max) ? entry : max;
+        }
+
+        column_mean[i] = (n > 2) ? sum / (n - 2) : 0.0;
+        column_max[i] = max;
+        ++index;
+    }
+}
+
+
+/* features of branching candidate i (see above) */
+static void candidateFeatures(const BabNode *node, int i, int num_free, double *feature) {
+
+    feature[0] = 1.0 - 2.0 * fabs(node->fracsol[i] - 0.5);
+    feature[1] = column_mean[i];
+    feature[2] = column_max[i];
+
+    int neighbours = 0;
+    for (int j = 0; j < BabPbSize; ++j) {
+        if (j != i && !node->xfixed[j] && SP->L[j + i * SP->n] != 0.0)
+            ++neighbours;
+    }
+    feature[3] = (num_free > 1) ? (double) neighbours / (num_free - 1) : 0.0;
+
+    double count;
+    pseudoCostEstimates(i, &feature[4], &count);
+    feature[6] = log(1.0 + count);
+}
+
+
+/* free variable of node with the largest learned score, -1 if all variables are fixed */
+int learnedBranchingVariable(BabNode *node) {
+
+    int num_free = BabPbSize - countFixedVariables(node);
+    int ic = -1;
+    double best_score = -INFINITY;
+    double feature[SCORER_BRANCH_FEATURES];
+
+    for (int i = 0; i < BabPbSize; ++i) {
+
+        if (node->xfixed[i])
+            continue;
+
+        candidateFeatures(node, i, num_free, feature);
+
+        double score = branch_weights[0];
+        for (int k = 0; k < SCORER_BRANCH_FEATURES; ++k)
+            score += branch_weights[k + 1] * feature[k];
+
+        if (score > best_score) {
+            best_score = score;
+            ic = i;
+        }
+    }
+
+    return ic;
+}
+
+
+/* priority of node in the queue (compare_Nodes): upper bound or learned score, must be set before insertion */
+void setNodePriority(BabNode *node) {
+
+    // unevaluated children are ordered by their pre-bound
+    double bound = (node->prebound < node->upper_bound) ? node->prebound : node->upper_bound;
+
+    if (!node_loaded) {
+        node->priority = bound;
+        return;
+    }
+
+    // the term -w_2 * lower bound is the same for all nodes
+    node->priority = node_weights[0]
+                   + node_weights[1] * node->level
+                   + node_weights[2] * bound
+                   + node_weights[3] * (BabPbSize - countFixedVariables(node));
+}
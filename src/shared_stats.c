@@ -0,0 +1,125 @@
+/* Search statistics shared by all processes */
+
+/*
+ * Modules that learn from the search (e.g. pseudo-costs) register a block of
+ * doubles during initialization, so that all processes learn from the nodes
+ * evaluated by all processes. Values are only ever added. Statistics that
+ * depend on the depth of a node use the depth ranges of SharedStats_DepthRange. Each worker keeps
+ * the totals it knows (last global totals plus own contributions) and the own
+ * contributions since the last synchronization. Every params.stats_sync_interval
+ * evaluated nodes a worker sends its contributions to the master (message
+ * SYNC_STATS), the master adds them to the global totals and sends the totals
+ * back. The master adds its own contributions directly to the global totals.
+ *
+ * If nothing is registered no messages are sent.
+ */
+
+#include <string.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+
+static double *stats_total = NULL;      // totals known to this process
+static double *stats_delta = NULL;      // own contributions since last sync
+static int stats_size = 0;
+static int stats_rank = -1;
+static int nodes_since_sync = 0;
+
+
+/* register block of size doubles (all processes in the same order), returns its offset */
+int SharedStats_Register(int size) {
+
+    int offset = stats_size;
+    stats_size += size;
+
+    stats_total = realloc(stats_total, stats_size * sizeof(double));
+    stats_delta = realloc(stats_delta, stats_size * sizeof(double));
+    if (stats_total == NULL || stats_delta == NULL) {
+        fprintf(stderr, "Error: Not enough memory for shared statistics.\n");
+        abort_alloc_fail(10);
+    }
+
+    for (int i = offset; i < stats_size; ++i) {
+        stats_total[i] = 0.0;
+        stats_delta[i] = 0.0;
+    }
+
+    if (stats_rank < 0)
+        MPI_Comm_rank(MPI_COMM_WORLD, &stats_rank);
+
+    return offset;
+}
+
+
+/*
+ * Depth range of a node at level (0-1, 2-3, 4-7, >= 8): the tree is
+ * explored best first, so deep levels have few nodes and share one range.
+ */
+int SharedStats_DepthRange(int level) {
+
+    if (level < 2)
+        return 0;
+    if (level < 4)
+        return 1;
+    if (level < 8)
+        return 2;
+    return 3;
+}
+
+
+/* current totals known to this process */
+const double *SharedStats_Get(int offset) {
+    return stats_total + offset;
+}
+
+
+void SharedStats_Add(int index, double value) {
+
+    stats_total[index] += value;
+
+    if (stats_rank != 0)
+        stats_delta[index] += value;
+}
+
+
+/* WORKER: count evaluated node and synchronize with master if due */
+void SharedStats_NodeDone(void) {
+
+    if (stats_size == 0 || ++nodes_since_sync < params.stats_sync_interval)
+        return;
+
+    Message message = SYNC_STATS;
+    MPI_Status status;
+
+    MPI_Send(&message, 1, MPI_INT, 0, MESSAGE, MPI_COMM_WORLD);
+    MPI_Send(stats_delta, stats_size, MPI_DOUBLE, 0, STATS, MPI_COMM_WORLD);
+    MPI_Recv(stats_total, stats_size, MPI_DOUBLE, 0, STATS, MPI_COMM_WORLD, &status);
+
+    memset(stats_delta, 0, stats_size * sizeof(double));
+    nodes_since_sync = 0;
+}
+
+
+/* MASTER: add contributions of source to the global totals and send them back */
+void SharedStats_MasterSync(int source) {
+
+    MPI_Status status;
+
+    MPI_Recv(stats_delta, stats_size, MPI_DOUBLE, source, STATS, MPI_COMM_WORLD, &status);
+
+    for (int i = 0; i < stats_size; ++i)
+        stats_total[i] += stats_delta[i];
+
+    MPI_Send(stats_total, stats_size, MPI_DOUBLE, source, STATS, MPI_COMM_WORLD);
+}
+
+
+void SharedStats_Free(void) {
+
+    free(stats_total);
+    free(stats_delta);
+    stats_total = NULL;
+    stats_delta = NULL;
+    stats_size = 0;
+}
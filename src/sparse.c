@@ -0,0 +1,110 @@
+/* Sparse storage of the objective for sparse graphs (params.sparse_density) */
+
+/*
+ * SP->L is dense. If the density of the Laplacian part (off-diagonal nonzeros
+ * of the upper left BabPbSize x BabPbSize block) is at most
+ * params.sparse_density, a CSR copy of it is built at the start and the
+ * routines that only need L (evaluateSolution, createSubproblem,
+ * getFixedValue, the 1-opt local search of the GW heuristic) work in
+ * O(number of nonzeros) instead of O(n^2). The SDP relaxation itself stays
+ * dense, as do the linear column of SP->L and of the subproblems.
+ */
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern Problem *SP;
+
+static SparseMatrix *laplacian = NULL;     // NULL: dense routines are used
+
+
+/* CSR of the off-diagonal nonzeros of the upper left m x m block of the n x n matrix A */
+SparseMatrix *sparseFromDense(const double *A, int n, int m) {
+
+    SparseMatrix *S;
+    alloc(S, SparseMatrix);
+    S->n = m;
+    alloc_vector(S->row_start, m + 1, int);
+    alloc_vector(S->diag, m, double);
+
+    int nnz = 0;
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < m; ++j) {
+            if (i != j && A[j + i*n] != 0.0)
+                ++nnz;
+        }
+    }
+    alloc_vector(S->col, nnz + 1, int);
+    alloc_vector(S->val, nnz + 1, double);
+
+    nnz = 0;
+    for (int i = 0; i < m; ++i) {
+        S->row_start[i] = nnz;
+        S->diag[i] = A[i + i*n];
+        for (int j = 0; j < m; ++j) {
+            if (i != j && A[j + i*n] != 0.0) {
+                S->col[nnz] = j;
+                S->val[nnz] = A[j + i*n];
+                ++nnz;
+            }
+        }
+    }
+    S->row_start[m] = nnz;
+
+    return S;
+}
+
+
+void freeSparseMatrix(SparseMatrix *S) {
+
+    if (S == NULL)
+        return;
+
+    free(S->row_start);
+    free(S->col);
+    free(S->val);
+    free(S->diag);
+    free(S);
+}
+
+
+/* Switch to the sparse routines if the Laplacian of SP is sparse enough */
+void initSparse(int rank) {
+
+    if (params.sparse_density <= 0.0 || BabPbSize < 2)
+        return;
+
+    int N = SP->n;
+    long long nnz = 0;
+    for (int i = 0; i < BabPbSize; ++i) {
+        for (int j = 0; j < BabPbSize; ++j) {
+            if (i != j && SP->L[j + i*N] != 0.0)
+                ++nnz;
+        }
+    }
+
+    double density = (double) nnz / ((double) BabPbSize * (BabPbSize - 1));
+
+    if (density > params.sparse_density)
+        return;
+
+    laplacian = sparseFromDense(SP->L, N, BabPbSize);
+
+    if (rank == 0)
+        printf("Sparse: density of the Laplacian is %.4f, sparse routines are used\n", density);
+}
+
+
+/* CSR of the Laplacian of SP, NULL if the dense routines are used */
+const SparseMatrix *sparseLaplacian(void) {
+
+    return laplacian;
+}
+
+
+void freeSparse(void) {
+
+    freeSparseMatrix(laplacian);
+    laplacian = NULL;
+}
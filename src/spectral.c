@@ -0,0 +1,231 @@
+/* Eigenvalue bound as a cheap pre-bound before the basic SDP relaxation (params.spectral_iter) */
+
+/*
+ * For every u in R^n and y in {-1,1}^n
+ *   y'Ly = y'(L + Diag(u))y - e'u <= n lambda_max(L + Diag(u)) - e'u,
+ * and the minimum over u equals the basic SDP bound. The bound is minimized
+ * by params.spectral_iter subgradient steps (subgradient n v.^2 - e for the
+ * top eigenvector v), lambda_max is estimated by Lanczos with full
+ * reorthogonalization, warm started from the previous eigenvector.
+ *
+ * A Ritz value is only a lower estimate of lambda_max: as soon as the
+ * estimate theta + ||residual|| proves pruning, it is certified by a Cholesky
+ * factorization of (theta + ||residual||)(1 + eps) I - L - Diag(u).
+ */
+
+#include <math.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+
+#define SPECTRAL_LANCZOS_STEPS 30
+#define SPECTRAL_MARGIN 1e-8
+
+
+/*
+ * Largest Ritz value of the symmetric n x n matrix A after at most
+ * SPECTRAL_LANCZOS_STEPS Lanczos steps from v (normalized on exit to the Ritz
+ * vector), the residual norm ||Av - theta v|| is stored in residual.
+ */
+static double lanczos(double *A, int n, double *v, double *residual) {
+
+    int k_max = (n < SPECTRAL_LANCZOS_STEPS) ? n : SPECTRAL_LANCZOS_STEPS;
+    int inc = 1;
+    char UPLO = 'L';
+    double one = 1.0, zero = 0.0;
+
+    double *Q, *w, *alpha, *beta, *T, *work;
+    alloc_vector(Q, (k_max + 1) * n, double);
+    alloc_vector(w, n, double);
+    alloc_vector(alpha, k_max, double);
+    alloc_vector(beta, k_max, double);
+    alloc_matrix(T, k_max, double);
+    alloc_vector(work, 2 * k_max, double);
+
+    double norm = dnrm2_(&n, v, &inc);
+    for (int i = 0; i < n; ++i)
+        Q[i] = v[i] / norm;
+
+    int k;
+    for (k = 0; k < k_max; ++k) {
+
+        double *q = Q + k*n;
+
+        // w = A q
+        dsymv_(&UPLO, &n, &one, A, &n, q, &inc, &zero, w, &inc);
+        alpha[k] = ddot_(&n, q, &inc, w, &inc);
+
+        // full reorthogonalization against q_0, ..., q_k (twice for stability)
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int j = 0; j <= k; ++j) {
+                double c = -ddot_(&n, Q + j*n, &inc, w, &inc);
+                daxpy_(&n, &c, Q + j*n, &inc, w, &inc);
+            }
+        }
+
+        beta[k] = dnrm2_(&n, w, &inc);
+
+        // invariant subspace found
+        if (k + 1 == k_max || beta[k] < 1e-10) {
+            ++k;
+            break;
+        }
+
+        double scale = 1.0 / beta[k];
+        for (int i = 0; i < n; ++i)
+            Q[(k + 1)*n + i] = w[i] * scale;
+    }
+
+    /* eigenvalues and eigenvectors of the tridiagonal k x k matrix (ascending) */
+    char JOBZ = 'V';
+    int info;
+    dstev_(&JOBZ, &k, alpha, beta, T, &k, work, &info);
+
+    double theta;
+
+    if (info != 0) {
+        // no estimate: +infinity never proves pruning
+        theta = BIG_NUMBER;
+        *residual = 0.0;
+    }
+    else {
+        theta = alpha[k - 1];
+
+        // Ritz vector v = Q y for the eigenvector y of the largest eigenvalue
+        for (int i = 0; i < n; ++i)
+            v[i] = 0.0;
+        for (int j = 0; j < k; ++j) {
+            double y = T[j + (k - 1)*k];
+            daxpy_(&n, &y, Q + j*n, &inc, v, &inc);
+        }
+        norm = dnrm2_(&n, v, &inc);
+        for (int i = 0; i < n; ++i)
+            v[i] /= norm;
+
+        // residual ||A v - theta v||
+        dsymv_(&UPLO, &n, &one, A, &n, v, &inc, &zero, w, &inc);
+        double c = -theta;
+        daxpy_(&n, &c, v, &inc, w, &inc);
+        *residual = dnrm2_(&n, w, &inc);
+    }
+
+    free(Q);
+    free(w);
+    free(alpha);
+    free(beta);
+    free(T);
+    free(work);
+
+    return theta;
+}
+
+
+/* 1 if tau I - A is positive definite (A is n x n, symmetric) */
+static int certifyUpperBound(const double *A, int n, double tau) {
+
+    int nn = n * n;
+    int inc = 1;
+    int info;
+    char UPLO = 'L';
+    double *M;
+
+    alloc_matrix(M, n, double);
+    dcopy_(&nn, (double *) A, &inc, M, &inc);
+
+    double alpha = -1.0;
+    dscal_(&nn, &alpha, M, &inc);
+    for (int i = 0; i < n; ++i)
+        M[i + i*n] += tau;
+
+    dpotrf_(&UPLO, &n, M, &n, &info);
+    free(M);
+
+    return (info == 0);
+}
+
+
+/*
+ * Try to prove max y'(PP->L)y < threshold with the eigenvalue bound.
+ * Returns 1 and the certified bound in bound if successful, 0 otherwise.
+ */
+int spectralBound(const Problem *PP, double threshold, double *bound) {
+
+    int n = PP->n;
+    int nn = n * n;
+    int inc = 1;
+
+    double *A, *u, *v;
+    alloc_matrix(A, n, double);
+    alloc_vector(u, n, double);
+    alloc_vector(v, n, double);
+
+    dcopy_(&nn, PP->L, &inc, A, &inc);
+
+    // start with constant diagonal: u = mean(diag(L)) - diag(L), e'u = 0
+    double mean = 0.0;
+    for (int i = 0; i < n; ++i)
+        mean += PP->L[i + i*n];
+    mean /= n;
+
+    for (int i = 0; i < n; ++i) {
+        u[i] = mean - PP->L[i + i*n];
+        A[i + i*n] = mean;
+        v[i] = 1.0 + (double) (i % 7) / 7.0;
+    }
+
+    int proved = 0;
+    double step_scale = 1.0;
+    double best = BIG_NUMBER;
+
+    for (int iter = 0; iter < params.spectral_iter && !proved; ++iter) {
+
+        double residual;
+        double theta = lanczos(A, n, v, &residual);
+        if (theta >= BIG_NUMBER)
+            break;
+
+        double sum_u = 0.0;
+        for (int i = 0; i < n; ++i)
+            sum_u += u[i];
+
+        double estimate = n * (theta + residual) - sum_u;
+
+        if (estimate < threshold) {
+            double tau = (theta + residual) + SPECTRAL_MARGIN * (fabs(theta) + 1.0);
+            double certified = n * tau - sum_u;
+            if (certified < threshold && certifyUpperBound(A, n, tau)) {
+                *bound = certified;
+                proved = 1;
+            }
+            break;
+        }
+
+        // Polyak step towards the threshold, halved if the bound did not improve
+        if (estimate >= best)
+            step_scale *= 0.5;
+        else
+            best = estimate;
+
+        double g_norm2 = 0.0;
+        for (int i = 0; i < n; ++i) {
+            double g = n * v[i] * v[i] - 1.0;
+            g_norm2 += g * g;
+        }
+        if (g_norm2 < 1e-12)
+            break;
+
+        double step = step_scale * (estimate - threshold) / g_norm2;
+        for (int i = 0; i < n; ++i) {
+            double g = n * v[i] * v[i] - 1.0;
+            u[i] -= step * g;
+            A[i + i*n] = PP->L[i + i*n] + u[i];
+        }
+    }
+
+    free(A);
+    free(u);
+    free(v);
+
+    return proved;
+}
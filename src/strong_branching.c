@@ -0,0 +1,331 @@
+/* Strong branching: choose the branching variable with truncated SDP bounds of the children */
+
+/*
+ * For the params.sb_candidates most fractional variables both children are
+ * built and bounded by
+ *   (1) the basic SDP relaxation (ipm_mc_pk), evaluated in parallel with
+ *       params.sb_threads threads (each thread has its own subproblems and
+ *       IPM workspace, ipm_mc_pk_work), in batches of the batched IPM
+ *       (ipm_mc_pk_batch) with params.ipm_batch, and
+ *   (2) params.sb_bundle_iter iterations of the bundle method started from
+ *       the cuts and multipliers of the parent (serial, uses the global
+ *       bundle data).
+ * The variable with the best score of the bound decreases of its two
+ * children is chosen (product or minimum, params.sb_score). The number of
+ * these decisions is counted for the final output.
+ *
+ * Must be called directly after the node was evaluated: the cuts of the
+ * parent are taken from PP. Overwrites the global bundle data (X, PP, cuts).
+ */
+
+#include <math.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern Problem *SP;
+extern Problem *PP;
+extern double granularity;
+
+extern double f;
+extern double *dual_gamma;
+
+/* one child of a candidate */
+typedef struct Probe
+{
+    BabNode child;
+    double bound;
+} Probe;
+
+/* work shared by the threads evaluating the basic bounds */
+typedef struct ProbeWork
+{
+    Probe *probes;
+    int num_probes;
+    int next;               // next probe to evaluate
+    int batch;              // probes taken at once (batched IPM)
+    pthread_mutex_t lock;
+} ProbeWork;
+
+
+/*
+ * Basic SDP bounds of count <= IPM_BATCH children (one batch of
+ * params.ipm_batch), P, XX and the IPM workspace are owned by the caller.
+ */
+static void probeBasicBounds(Probe *probes, int count, Problem *P, double **XX, double *work) {
+
+    double phi[IPM_BATCH];
+    double *L[IPM_BATCH];
+    int same_size = 1;
+
+    for (int k = 0; k < count; ++k) {
+        createSubproblem(&probes[k].child, SP, &P[k]);
+        L[k] = P[k].L;
+        same_size &= (P[k].n == P[0].n);
+    }
+
+    if (count > 1 && same_size) {
+        ipm_mc_pk_batch(L, XX, phi, count, P[0].n, -BIG_NUMBER);
+    }
+    else {
+        for (int k = 0; k < count; ++k)
+            ipm_mc_pk_work(P[k].L, P[k].n, XX[k], &phi[k], 0, -BIG_NUMBER, BIG_NUMBER, work);
+    }
+
+    for (int k = 0; k < count; ++k)
+        probes[k].bound = phi[k] + getFixedValue(&probes[k].child, SP);
+}
+
+
+static void *probeThread(void *arg) {
+
+    ProbeWork *work = (ProbeWork *) arg;
+    int batch = work->batch;
+    Problem P[IPM_BATCH];
+    double *XX[IPM_BATCH];
+    double *ipm;           // IPM workspace of this thread
+
+    // subproblems of the children are smaller than the original problem
+    for (int k = 0; k < batch; ++k) {
+        alloc_matrix(P[k].L, SP->n, double);
+        alloc_matrix(XX[k], SP->n, double);
+    }
+    alloc_vector(ipm, IPM_WORKSPACE_SIZE(SP->n), double);
+
+    while (1) {
+        pthread_mutex_lock(&work->lock);
+        int first = work->next;
+        work->next += batch;
+        pthread_mutex_unlock(&work->lock);
+
+        if (first >= work->num_probes)
+            break;
+
+        int count = (work->num_probes - first < batch) ? work->num_probes - first : batch;
+        probeBasicBounds(&work->probes[first], count, P, XX, ipm);
+    }
+
+    for (int k = 0; k < batch; ++k) {
+        free(P[k].L);
+        free(XX[k]);
+    }
+    free(ipm);
+
+    return NULL;
+}
+
+
+/* improve bound of probe with a few bundle iterations starting from the cuts of the parent */
+static void probeBundleBound(Probe *probe, const CutPool *pool) {
+
+    createSubproblem(&probe->child, SP, PP);
+
+    if (loadCuts(pool, &probe->child, PP, dual_gamma) == 0)
+        return;
+
+    // dual function at any nonnegative multipliers is an upper bound
+    bundle_init(PP, 1);
+
+    double fixedvalue = getFixedValue(&probe->child, SP);
+    double gap = f + fixedvalue - Bab_LBGet();
+
+    if (gap > granularity) {
+        double t = 0.5 * gap / (PP->NIneq + PP->NPentIneq + PP->NHeptaIneq);
+        bundle_method(PP, &t, params.sb_bundle_iter);
+    }
+
+    if (f + fixedvalue < probe->bound)
+        probe->bound = f + fixedvalue;
+}
+
+
+/*
+ * Store the (at most max_candidates) most fractional variables of eligible in candidates,
+ * eligible = NULL means all free variables. Returns the number of candidates.
+ */
+int selectFractionalCandidates(BabNode *node, const int *eligible, int num_eligible, int max_candidates, int *candidates) {
+
+    int num_candidates = 0;
+    int pos;
+
+    if (eligible == NULL)
+        num_eligible = BabPbSize;
+
+    /* insertion sort by fractionality */
+    for (int e = 0; e < num_eligible; ++e) {
+
+        int i = (eligible == NULL) ? e : eligible[e];
+
+        if (node->xfixed[i])
+            continue;
+
+        double frac = fabs(0.5 - node->fracsol[i]);
+
+        if (num_candidates < max_candidates)
+            pos = num_candidates++;
+        else if (frac < fabs(0.5 - node->fracsol[candidates[max_candidates - 1]]))
+            pos = max_candidates - 1;
+        else
+            continue;
+
+        while (pos > 0 && fabs(0.5 - node->fracsol[candidates[pos - 1]]) > frac) {
+            candidates[pos] = candidates[pos - 1];
+            --pos;
+        }
+        candidates[pos] = i;
+    }
+
+    return num_candidates;
+}
+
+
+/* Store the (at most max_candidates) least fractional free variables in candidates, returns their number */
+int selectIntegralCandidates(BabNode *node, int max_candidates, int *candidates) {
+
+    int num_candidates = 0;
+    int pos;
+
+    /* insertion sort by fractionality */
+    for (int i = 0; i < BabPbSize; ++i) {
+
+        if (node->xfixed[i])
+            continue;
+
+        double frac = fabs(0.5 - node->fracsol[i]);
+
+        if (num_candidates < max_candidates)
+            pos = num_candidates++;
+        else if (frac > fabs(0.5 - node->fracsol[candidates[max_candidates - 1]]))
+            pos = max_candidates - 1;
+        else
+            continue;
+
+        while (pos > 0 && fabs(0.5 - node->fracsol[candidates[pos - 1]]) < frac) {
+            candidates[pos] = candidates[pos - 1];
+            --pos;
+        }
+        candidates[pos] = i;
+    }
+
+    return num_candidates;
+}
+
+
+/*
+ * Truncated bounds of both children of every candidate:
+ * bounds[2*c + xic] is the bound of the child with x[candidates[c]] = xic.
+ */
+void strongBranchingProbe(BabNode *node, const int *candidates, int num_candidates, double *bounds) {
+
+    /* children of all candidates: probes[2*c + xic] */
+    Probe *probes;
+    int num_probes = 2 * num_candidates;
+    alloc_vector(probes, num_probes, Probe);
+
+    for (int c = 0; c < num_candidates; ++c) {
+        for (int xic = 0; xic <= 1; ++xic) {
+            Probe *probe = &probes[2 * c + xic];
+            for (int i = 0; i < BabPbSize; ++i) {
+                probe->child.xfixed[i] = node->xfixed[i];
+                probe->child.sol.X[i] = node->sol.X[i];
+            }
+            probe->child.xfixed[candidates[c]] = 1;
+            probe->child.sol.X[candidates[c]] = xic;
+            probe->child.level = node->level + 1;
+        }
+    }
+
+    /* (1) basic SDP bounds */
+    int num_threads = (params.sb_threads < num_probes) ? params.sb_threads : num_probes;
+
+    // batches are not larger than the share of a thread
+    int batch = (num_threads > 1) ? (num_probes + num_threads - 1) / num_threads : num_probes;
+    batch = (!params.ipm_batch) ? 1 : (batch < IPM_BATCH) ? batch : IPM_BATCH;
+    ProbeWork work = { probes, num_probes, 0, batch, PTHREAD_MUTEX_INITIALIZER };
+
+    if (num_threads > 1) {
+        pthread_t threads[num_threads];
+        for (int t = 0; t < num_threads; ++t)
+            pthread_create(&threads[t], NULL, probeThread, &work);
+        for (int t = 0; t < num_threads; ++t)
+            pthread_join(threads[t], NULL);
+    }
+    else {
+        probeThread(&work);
+    }
+
+    /* (2) bundle iterations with the cuts of the parent for children that are not pruned */
+    if (params.sb_bundle_iter > 0 && PP->NIneq + PP->NPentIneq + PP->NHeptaIneq > 0) {
+
+        CutPool *pool = saveCuts(node, PP, dual_gamma);
+
+        for (int p = 0; p < num_probes && !timeLimitReached(); ++p) {
+            if (probes[p].bound >= Bab_LBGet() + granularity)
+                probeBundleBound(&probes[p], pool);
+        }
+
+        freeCutPool(pool);
+    }
+
+    for (int p = 0; p < num_probes; ++p)
+        bounds[p] = probes[p].bound;
+
+    free(probes);
+}
+
+
+/* summed over all processes at the end */
+int num_strong_branchings = 0;      // nodes branched on the variable chosen by the probes
+int num_strong_changes = 0;         // ... that is not the most fractional candidate
+
+int strongBranchingVariable(BabNode *node) {
+
+    int max_candidates = (params.sb_candidates > 1) ? params.sb_candidates : 1;
+    int candidates[max_candidates];
+    int num_candidates = selectFractionalCandidates(node, NULL, 0, max_candidates, candidates);
+
+    if (num_candidates <= 1)
+        return (num_candidates == 1) ? candidates[0] : -1;
+
+    double bounds[2 * num_candidates];
+    strongBranchingProbe(node, candidates, num_candidates, bounds);
+
+    /*
+     * score: decrease of the bound in both children. The truncated bounds of
+     * the children are often all above the bound of the parent (which has
+     * converged cuts), the decrease is then measured from the largest bound
+     * of the probes, which are all truncated the same way.
+     */
+    double reference = node->upper_bound;
+    for (int p = 0; p < 2 * num_candidates; ++p) {
+        if (bounds[p] > reference)
+            reference = bounds[p];
+    }
+
+    int ic = candidates[0];
+    double best_score = -BIG_NUMBER;
+
+    for (int c = 0; c < num_candidates; ++c) {
+
+        double drop0 = reference - bounds[2 * c];
+        double drop1 = reference - bounds[2 * c + 1];
+
+        drop0 = (drop0 > 1e-6) ? drop0 : 1e-6;
+        drop1 = (drop1 > 1e-6) ? drop1 : 1e-6;
+
+        double score = (params.sb_score == SB_SCORE_MIN) ?
+                       ((drop0 < drop1) ? drop0 : drop1) : drop0 * drop1;
+
+        if (score > best_score) {
+            best_score = score;
+            ic = candidates[c];
+        }
+    }
+
+    ++num_strong_branchings;
+    if (ic != candidates[0])
+        ++num_strong_changes;
+
+    return ic;
+}
@@ -0,0 +1,104 @@
+/* Online estimate of B&B subtree sizes */
+/* Used to decide which nodes are donated to free workers */
+
+#include <math.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern double granularity;
+
+/*
+ * Statistics collected from the nodes evaluated by this process:
+ * per depth the total decrease of the upper bound between parent and child
+ * and how many of the evaluated nodes had to be branched.
+ */
+static double drop_sum[NMAX];       // sum of (parent bound - node bound) of nodes at depth d
+static int drop_count[NMAX];        // number of nodes at depth d with known parent bound
+static double drop_avg[NMAX];       // drop_sum[d] / drop_count[d], set once depth d has 5 samples
+static double drop_total_sum = 0.0; // sums over all depths
+static int drop_total_count = 0;
+static int num_evaluated = 0;       // evaluated nodes
+static int num_branched = 0;        // evaluated nodes that were branched
+
+
+/* record the bound of an evaluated node (parent_bound is inherited from its parent) */
+void recordBoundDrop(int level, double parent_bound, double bound) {
+
+    if (level <= 0 || level >= NMAX || parent_bound >= BIG_NUMBER)
+        return;
+
+    // bound can be slightly larger than parent bound due to inexact SDP solutions
+    double drop = parent_bound - bound;
+    drop = (drop > 0.0) ? drop : 0.0;
+
+    drop_sum[level] += drop;
+    ++drop_count[level];
+    drop_total_sum += drop;
+    ++drop_total_count;
+
+    if (drop_count[level] >= 5)
+        drop_avg[level] = drop_sum[level] / drop_count[level];
+}
+
+
+/* record whether an evaluated node was branched or pruned */
+void recordNodeOutcome(int branched) {
+
+    ++num_evaluated;
+    if (branched)
+        ++num_branched;
+}
+
+
+/* average decrease of the bound when going from depth level-1 to level */
+static double averageDrop(int level) {
+
+    // use statistics of the given depth if there are enough samples ...
+    if (level < NMAX && drop_count[level] >= 5)
+        return drop_avg[level];
+
+    // ... otherwise average over all depths
+    return (drop_total_count > 0) ? drop_total_sum / drop_total_count : 0.0;
+}
+
+
+/*
+ * Estimated log2 of the number of nodes in the subtree rooted at node.
+ *
+ * The gap (upper bound or pre-bound - lower bound) has to be closed before
+ * the subtree is pruned. Going down one level closes averageDrop(level) of
+ * the gap on average, which gives the expected remaining depth k (at most
+ * the number of free variables). With effective branching factor b, measured as
+ * 2 * (branched / evaluated), the subtree has about b^k nodes.
+ */
+double estimateSubtreeSize(BabNode *node) {
+
+    double bound = (node->prebound < node->upper_bound) ? node->prebound : node->upper_bound;
+    double gap = bound - Bab_LBGet();
+    if (gap < granularity)
+        return 0.0;
+
+    int free_vars = BabPbSize - countFixedVariables(node);
+
+    // effective branching factor
+    double b = (num_evaluated > 0) ? 2.0 * num_branched / num_evaluated : 2.0;
+    if (b <= 1.0)
+        return 0.0;
+
+    // without any statistics assume that every level closes the same part of the gap
+    if (averageDrop(node->level + 1) <= 0.0)
+        return free_vars * log2(b);
+
+    int k = 0;
+    while (gap >= granularity && k < free_vars) {
+        ++k;
+        double drop = averageDrop(node->level + k);
+        if (drop <= 0.0)
+            break;
+        gap -= drop;
+    }
+
+    return k * log2(b);
+}
@@ -0,0 +1,410 @@
+/* Graph automorphisms and orbital branching (params.symmetry) */
+
+/*
+ * A permutation s of the vertices with s(last) = last and
+ * L[s(i)][s(j)] = L[i][j] for all i, j (L = SP->L, including the diagonal and
+ * the linear row) maps solutions to solutions of the same value.
+ *
+ * Automorphisms are found by partition refinement with individualization:
+ * vertices are colored, a color is refined by the multiset of (weight, color)
+ * of the neighbors until the partition is equitable. To map u to v, u is
+ * individualized in one copy of the graph and v in another, both copies are
+ * refined jointly, and vertices of the first non-singleton cell are
+ * individualized in turn until the partitions are discrete. Every candidate
+ * permutation is verified, a search is stopped after SYMMETRY_BUDGET
+ * refinements (the orbits are then only those of the automorphisms found).
+ *
+ * At a node, fixed and linked variables (and the partners of linked
+ * variables) are individualized, so the automorphisms found fix them and map
+ * the subproblem of the node to itself. Orbital branching on the orbit O of
+ * the branching variable x[ic]: x[ic] = v in one child, x[j] = 1 - v for all
+ * j in O in the other child (a solution with x[j] = v for some j in O is
+ * mapped to one with x[ic] = v).
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern Problem *SP;
+
+#define SYMMETRY_BUDGET 1000
+
+/* nonzero off-diagonal entries of SP->L */
+static int *adj_start = NULL;
+static int *adj = NULL;
+static uint64_t *adj_weight = NULL;
+
+static int has_symmetry = 0;        // nontrivial automorphism found at the root
+static int budget;                  // remaining refinements of the current search
+
+typedef struct HashIndex
+{
+    uint64_t hash;
+    int index;
+} HashIndex;
+
+
+static uint64_t mix(uint64_t x) {
+
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+static uint64_t weightHash(double w) {
+
+    uint64_t bits;
+    memcpy(&bits, &w, sizeof(bits));
+    return mix(bits);
+}
+
+
+static int compareHash(const void *a, const void *b) {
+
+    const HashIndex *x = (const HashIndex *) a;
+    const HashIndex *y = (const HashIndex *) b;
+
+    if (x->hash != y->hash)
+        return (x->hash < y->hash) ? -1 : 1;
+    return x->index - y->index;
+}
+
+
+/*
+ * Refine the colors of num_copies copies of the graph (color[k*N + v]) jointly
+ * until the partition is equitable. Colors are renumbered 0, 1, ... in the
+ * same way in all copies. Returns the number of colors.
+ */
+static int refine(int *color, int num_copies) {
+
+    int N = SP->n;
+    int total = num_copies * N;
+    uint64_t *hash;
+    HashIndex *sorted;
+    int num_colors = -1;
+
+    alloc_vector(hash, total, uint64_t);
+    alloc_vector(sorted, total, HashIndex);
+
+    while (1) {
+
+        for (int k = 0; k < num_copies; ++k) {
+            const int *c = color + k*N;
+            for (int v = 0; v < N; ++v) {
+                // sum over neighbors: the hash does not depend on their order
+                uint64_t h = mix((uint64_t) c[v]);
+                for (int e = adj_start[v]; e < adj_start[v + 1]; ++e)
+                    h += mix(adj_weight[e] ^ mix((uint64_t) c[adj[e]] + 1));
+                hash[k*N + v] = h;
+            }
+        }
+
+        for (int t = 0; t < total; ++t) {
+            sorted[t].hash = hash[t];
+            sorted[t].index = t;
+        }
+        qsort(sorted, total, sizeof(HashIndex), compareHash);
+
+        int id = 0;
+        for (int t = 0; t < total; ++t) {
+            if (t > 0 && sorted[t].hash != sorted[t - 1].hash)
+                ++id;
+            color[sorted[t].index] = id;
+        }
+
+        // refinement only splits cells: stop if no cell was split
+        if (id + 1 == num_colors)
+            break;
+        num_colors = id + 1;
+    }
+
+    free(hash);
+    free(sorted);
+
+    return num_colors;
+}
+
+
+/* 1 if permutation s is an automorphism of SP->L */
+static int isAutomorphism(const int *s) {
+
+    int N = SP->n;
+
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            if (SP->L[s[j] + s[i]*N] != SP->L[j + i*N])
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+/*
+ * Search an automorphism mapping the coloring of copy 0 to the coloring of
+ * copy 1 of color (2N entries). Returns 1 and the permutation in s if found.
+ */
+static int searchAutomorphism(const int *color, int *s) {
+
+    int N = SP->n;
+
+    if (--budget < 0)
+        return 0;
+
+    int *c;
+    alloc_vector(c, 2 * N, int);
+    memcpy(c, color, 2 * N * sizeof(int));
+
+    int num_colors = refine(c, 2);
+
+    /* cells must have the same size in both copies */
+    int *count;
+    alloc_vector(count, 2 * num_colors, int);
+    for (int v = 0; v < N; ++v) {
+        ++count[c[v]];
+        ++count[num_colors + c[N + v]];
+    }
+
+    int found = 0;
+    int balanced = 1;
+    int target = -1;                // first non-singleton cell
+
+    for (int id = 0; id < num_colors; ++id) {
+        if (count[id] != count[num_colors + id])
+            balanced = 0;
+        if (target < 0 && count[id] > 1)
+            target = id;
+    }
+
+    if (balanced && target < 0) {
+        // discrete: s(v) is the vertex of copy 1 with the color of v
+        int where[num_colors];
+        for (int v = 0; v < N; ++v)
+            where[c[N + v]] = v;
+        for (int v = 0; v < N; ++v)
+            s[v] = where[c[v]];
+        found = isAutomorphism(s);
+    }
+    else if (balanced) {
+        // individualize the first vertex of the cell in copy 0 and each vertex of the cell in copy 1
+        int a = 0;
+        while (c[a] != target)
+            ++a;
+
+        int *next;
+        alloc_vector(next, 2 * N, int);
+
+        for (int b = 0; b < N && !found && budget > 0; ++b) {
+            if (c[N + b] != target)
+                continue;
+            memcpy(next, c, 2 * N * sizeof(int));
+            next[a] = num_colors;
+            next[N + b] = num_colors;
+            found = searchAutomorphism(next, s);
+        }
+
+        free(next);
+    }
+
+    free(count);
+    free(c);
+
+    return found;
+}
+
+
+/* union-find */
+static int findRoot(int *parent, int v) {
+
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+
+/*
+ * Orbits of the automorphisms that respect color (N entries, already refined):
+ * parent is a union-find structure of the vertices. Only vertices in the cells
+ * of the vertices listed in start are searched (all if start == NULL).
+ * Returns the number of automorphisms found.
+ */
+static int findOrbits(const int *color, int *parent, const int *start, int num_start) {
+
+    int N = SP->n;
+    int num_found = 0;
+    int *pair, *s;
+
+    alloc_vector(pair, 2 * N, int);
+    alloc_vector(s, N, int);
+
+    for (int v = 0; v < N; ++v)
+        parent[v] = v;
+
+    int num_u = (start == NULL) ? N : num_start;
+
+    for (int t = 0; t < num_u; ++t) {
+
+        int u = (start == NULL) ? t : start[t];
+
+        for (int v = 0; v < N; ++v) {
+
+            if (v == u || color[v] != color[u] || findRoot(parent, u) == findRoot(parent, v))
+                continue;
+
+            // copy 0: u individualized, copy 1: v individualized
+            memcpy(pair, color, N * sizeof(int));
+            memcpy(pair + N, color, N * sizeof(int));
+            pair[u] = N;
+            pair[N + v] = N;
+
+            budget = SYMMETRY_BUDGET;
+            if (searchAutomorphism(pair, s)) {
+                ++num_found;
+                for (int i = 0; i < N; ++i) {
+                    int ri = findRoot(parent, i);
+                    int rs = findRoot(parent, s[i]);
+                    if (ri != rs)
+                        parent[ri] = rs;
+                }
+            }
+        }
+    }
+
+    free(pair);
+    free(s);
+
+    return num_found;
+}
+
+
+/* Preprocessing: adjacency of SP->L and orbits of the automorphism group */
+void initSymmetry(int rank) {
+
+    if (!params.symmetry)
+        return;
+
+    int N = SP->n;
+
+    alloc_vector(adj_start, N + 1, int);
+    int nnz = 0;
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            if (i != j && SP->L[j + i*N] != 0.0)
+                ++nnz;
+        }
+    }
+    alloc_vector(adj, nnz + 1, int);
+    alloc_vector(adj_weight, nnz + 1, uint64_t);
+
+    nnz = 0;
+    for (int i = 0; i < N; ++i) {
+        adj_start[i] = nnz;
+        for (int j = 0; j < N; ++j) {
+            if (i != j && SP->L[j + i*N] != 0.0) {
+                adj[nnz] = j;
+                adj_weight[nnz] = weightHash(SP->L[j + i*N]);
+                ++nnz;
+            }
+        }
+    }
+    adj_start[N] = nnz;
+
+    /* initial colors: diagonal entries, the last vertex is fixed */
+    int color[N];
+    int parent[N];
+    for (int i = 0; i < N; ++i)
+        color[i] = (int) (weightHash(SP->L[i + i*N]) >> 33);
+    color[N - 1] = -1;
+    refine(color, 1);
+
+    findOrbits(color, parent, NULL, 0);
+
+    int num_orbits = 0;
+    int largest = 0;
+    for (int v = 0; v < N - 1; ++v) {
+        if (findRoot(parent, v) != v)
+            continue;
+        ++num_orbits;
+        int size = 0;
+        for (int w = 0; w < N - 1; ++w)
+            size += (findRoot(parent, w) == v);
+        largest = (size > largest) ? size : largest;
+    }
+
+    has_symmetry = (num_orbits < N - 1);
+
+    if (rank == 0)
+        printf("Symmetry: %d orbits of variables, largest orbit has %d variables\n", num_orbits, largest);
+}
+
+
+/*
+ * Orbit of variable ic under the automorphisms that fix all fixed and linked
+ * variables of node. Stores the orbit in orbit and returns its size.
+ */
+int symmetryOrbit(BabNode *node, int ic, int *orbit) {
+
+    orbit[0] = ic;
+
+    if (!has_symmetry)
+        return 1;
+
+    int N = SP->n;
+    int color[N];
+    int parent[N];
+
+    for (int i = 0; i < N; ++i)
+        color[i] = 0;
+
+    // individualized: last vertex, fixed and linked variables and partners of linked variables
+    int next = 1;
+    color[N - 1] = next++;
+    for (int i = 0; i < BabPbSize; ++i) {
+        if (node->xfixed[i]) {
+            color[i] = next++;
+            if (node->xfixed[i] == LINKED)
+                color[node->sol.X[i] / 2] = next++;
+        }
+    }
+
+    /* colors of the initial partition of the root */
+    int *base;
+    alloc_vector(base, N, int);
+    for (int i = 0; i < N; ++i)
+        base[i] = (int) (weightHash(SP->L[i + i*N]) >> 33);
+    for (int i = 0; i < N; ++i)
+        color[i] = (color[i] > 0) ? -color[i] : base[i];
+    free(base);
+
+    refine(color, 1);
+    findOrbits(color, parent, &ic, 1);
+
+    int size = 1;
+    for (int v = 0; v < BabPbSize; ++v) {
+        if (v != ic && !node->xfixed[v] && findRoot(parent, v) == findRoot(parent, ic))
+            orbit[size++] = v;
+    }
+
+    return size;
+}
+
+
+void freeSymmetry(void) {
+
+    free(adj_start);
+    free(adj);
+    free(adj_weight);
+    adj_start = NULL;
+    adj = NULL;
+    adj_weight = NULL;
+}
@@ -0,0 +1,122 @@
+/* Binary trace of the B&B tree for offline analysis (params.trace) */
+/* Every process writes the nodes it evaluated to <instance>.trace.<rank>, see read_trace.py */
+
+#include <string.h>
+
+#include "biqbin.h"
+
+extern BiqBinParameters params;
+extern int BabPbSize;
+extern double TIME;
+
+EvalStats eval_stats;                   // phase times of the last call of SDPbound
+
+static FILE *trace_file = NULL;
+static TraceRecord *trace_buffer = NULL;
+static int trace_used = 0;              // number of records in trace_buffer
+static int trace_rank = 0;
+static long long next_id = 0;           // local node counter
+
+
+/*
+ * Unique id of a new node: rank in the upper bits, local counter in the
+ * lower 40 bits. Ids are assigned also when tracing is off.
+ */
+long long Trace_NextId(void) {
+
+    static int rank = -1;
+
+    if (rank < 0)
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    return ((long long)rank << 40) | next_id++;
+}
+
+
+/* open trace file of this process and write the header */
+void Trace_Open(const char *instance, int rank) {
+
+    if (!params.trace)
+        return;
+
+    char trace_path[220];
+    snprintf(trace_path, sizeof(trace_path), "%s.trace.%d", instance, rank);
+
+    trace_file = fopen(trace_path, "wb");
+    if (!trace_file) {
+        fprintf(stderr, "Warning: Cannot create trace file %s, tracing disabled.\n", trace_path);
+        return;
+    }
+
+    alloc_vector(trace_buffer, TRACE_BUFFER_SIZE, TraceRecord);
+    trace_rank = rank;
+
+    // header: magic, version, record size, rank, problem size
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.rank = rank;
+    header.num_vars = BabPbSize;
+    fwrite(&header, sizeof(TraceHeader), 1, trace_file);
+}
+
+
+static void Trace_Flush(void) {
+
+    if (trace_used > 0)
+        fwrite(trace_buffer, sizeof(TraceRecord), trace_used, trace_file);
+    trace_used = 0;
+}
+
+
+/*
+ * Store evaluated node in the trace buffer.
+ * parent_bound: bound inherited from the parent, t_start: MPI_Wtime() before Evaluate,
+ * outcome: TRACE_PRUNED, TRACE_BRANCHED or TRACE_GIVEUP.
+ * Phase times and number of cuts are taken from eval_stats of the last SDPbound call.
+ */
+void Trace_Node(BabNode *node, double parent_bound, double t_start, int outcome) {
+
+    if (trace_file == NULL)
+        return;
+
+    TraceRecord *r = &trace_buffer[trace_used];
+
+    r->id = node->id;
+    r->parent_id = node->parent_id;
+    r->parent_bound = parent_bound;
+    r->bound = node->upper_bound;
+    r->incumbent = Bab_LBGet();
+    r->t_start = t_start - TIME;
+    r->t_total = MPI_Wtime() - t_start;
+    r->t_ipm = eval_stats.time_ipm;
+    r->t_bundle = eval_stats.time_bundle;
+    r->t_heuristic = eval_stats.time_heuristic;
+    r->t_separation = eval_stats.time_separation;
+    r->rank = trace_rank;
+    r->depth = node->level;
+    r->branch_var = node->branch_var;
+    r->outcome = outcome;
+    r->num_tri = eval_stats.num_tri;
+    r->num_pent = eval_stats.num_pent;
+    r->num_hepta = eval_stats.num_hepta;
+    r->unused = 0;
+
+    if (++trace_used == TRACE_BUFFER_SIZE)
+        Trace_Flush();
+}
+
+
+/* write remaining records and close trace file */
+void Trace_Close(void) {
+
+    if (trace_file == NULL)
+        return;
+
+    Trace_Flush();
+    fclose(trace_file);
+    free(trace_buffer);
+    trace_file = NULL;
+    trace_buffer = NULL;
+}
@@ -0,0 +1,149 @@
+/*
+ * Micro-benchmark for the relaxed concurrent priority queue (src/multiqueue.c).
+ *
+ * Every thread simulates the B&B node loop: pop a node, "branch" it into two
+ * children with slightly smaller upper bounds and insert them again, until
+ * the total number of operations is reached. Throughput of the MultiQueue is
+ * compared with a single heap protected by one global lock.
+ *
+ * Usage: ./bench_multiqueue [max_threads] [operations]
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "../src/biqbin.h"
+
+#define PREFILL 4096
+
+static MultiQueue *mq;
+static Heap *locked_heap;
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static long ops_per_thread;
+
+void abort_alloc_fail(int abort_code) {
+    exit(abort_code);
+}
+
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static BabNode *bench_node(double bound) {
+    // only the priority matters for the queues, skip the large arrays
+    BabNode *node = malloc(sizeof(BabNode));
+    if (node == NULL)
+        abort_alloc_fail(10);
+    node->upper_bound = node->priority = bound;
+    return node;
+}
+
+static void *multiqueue_worker(void *arg) {
+
+    unsigned int seed = (unsigned int)(size_t)arg;
+
+    for (long i = 0; i < ops_per_thread; ++i) {
+        BabNode *node = MQ_PopApprox(mq, &seed);
+        if (node == NULL)
+            continue;
+        double bound = node->upper_bound;
+        node->upper_bound = node->priority = bound - (rand_r(&seed) % 100) / 10.0;
+        MQ_Insert(mq, node, &seed);
+        // keep the queue size stable: every other pop produces a second child
+        if (i % 2 == 0) {
+            BabNode *other = MQ_PopApprox(mq, &seed);
+            if (other != NULL)
+                free(other);
+            MQ_Insert(mq, bench_node(bound - (rand_r(&seed) % 100) / 10.0), &seed);
+        }
+    }
+
+    return NULL;
+}
+
+static void *locked_heap_worker(void *arg) {
+
+    unsigned int seed = (unsigned int)(size_t)arg;
+
+    for (long i = 0; i < ops_per_thread; ++i) {
+        pthread_mutex_lock(&heap_lock);
+        if (locked_heap->used == 0) {
+            pthread_mutex_unlock(&heap_lock);
+            continue;
+        }
+        BabNode *node = Heap_Pop(locked_heap);
+        pthread_mutex_unlock(&heap_lock);
+
+        double bound = node->upper_bound;
+        node->upper_bound = node->priority = bound - (rand_r(&seed) % 100) / 10.0;
+
+        pthread_mutex_lock(&heap_lock);
+        Heap_Insert(locked_heap, node);
+        if (i % 2 == 0) {
+            BabNode *other = Heap_Pop(locked_heap);
+            free(other);
+            Heap_Insert(locked_heap, bench_node(bound - (rand_r(&seed) % 100) / 10.0));
+        }
+        pthread_mutex_unlock(&heap_lock);
+    }
+
+    return NULL;
+}
+
+static double run(void *(*worker)(void *), int num_threads) {
+
+    pthread_t threads[num_threads];
+    double start = wall_time();
+
+    for (int t = 0; t < num_threads; ++t)
+        pthread_create(&threads[t], NULL, worker, (void *)(size_t)(t + 1));
+    for (int t = 0; t < num_threads; ++t)
+        pthread_join(threads[t], NULL);
+
+    return wall_time() - start;
+}
+
+int main(int argc, char **argv) {
+
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    long total_ops = (argc > 2) ? atol(argv[2]) : 2000000;
+    unsigned int seed = 2020;
+
+    printf("%8s %16s %16s %10s\n", "threads", "locked [Mop/s]", "multiq [Mop/s]", "pruned");
+
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+
+        ops_per_thread = total_ops / num_threads;
+
+        /* single heap with one global lock */
+        locked_heap = Init_Heap(4 * PREFILL + 16);
+        for (int i = 0; i < PREFILL; ++i)
+            Heap_Insert(locked_heap, bench_node(rand_r(&seed) % 10000));
+        double t_locked = run(locked_heap_worker, num_threads);
+        for (int i = 0; i < locked_heap->used; ++i)
+            free(locked_heap->data[i]);
+        free(locked_heap->data);
+        free(locked_heap);
+
+        /* MultiQueue with 2 heaps per thread */
+        mq = MQ_Init(num_threads, 2, 4 * PREFILL + 16);
+        for (int i = 0; i < PREFILL; ++i)
+            MQ_Insert(mq, bench_node(rand_r(&seed) % 10000), &seed);
+        double t_multi = run(multiqueue_worker, num_threads);
+
+        // donations and pruning after a new incumbent
+        BabNode *donated[16];
+        int num_donated = MQ_ExtractBulk(mq, donated, 16);
+        for (int i = 0; i < num_donated; ++i)
+            free(donated[i]);
+        int pruned = MQ_PruneBelow(mq, 5000.0);
+        MQ_Free(mq);
+
+        printf("%8d %16.2f %16.2f %10d\n", num_threads,
+               1e-6 * total_ops / t_locked, 1e-6 * total_ops / t_multi, pruned);
+    }
+
+    return 0;
+}
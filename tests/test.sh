@@ -1,12 +1,14 @@
 #!/bin/bash
 
 # A test script for comparing solver output with expected output for a given problem instance.
-# Usage: ./test.sh biqbin instance expected_output params
+# Usage: ./test.sh biqbin instance expected_output params [required_output]
+# required_output: optional pattern (grep -E) that must match a line of the solver output,
+# e.g. a message that shows that the tested feature was used.
 
-if [ "$#" -ne 4 ]; then
+if [ "$#" -ne 4 ] && [ "$#" -ne 5 ]; then
     echo "Illegal number of parameters"
     echo "Usage:"
-    echo "./test.sh biqbin instance expected_output params"
+    echo "./test.sh biqbin instance expected_output params [required_output]"
     exit 1
 fi
 
@@ -59,7 +61,10 @@ output_filtered=$(echo "$output" | extract_comparison_lines)
 expected_output_filtered=$(cat "$3" | extract_comparison_lines)
 
 # Print result
-if [[ "$output_filtered" == "$expected_output_filtered" ]]; then
+if [ "$#" -eq 5 ] && ! echo "$output" | grep -Eq "$5"; then
+    echo "Failed! $2"
+    echo "Solver output has no line matching: $5"
+elif [[ "$output_filtered" == "$expected_output_filtered" ]]; then
     echo "O.K - ${2} Max val diff = ${max_val_diff}; Node diff = ${node_diff}; Root bound diff = ${root_node_bound_diff} Time diff = ${time_diff}s" 
 else
     echo "Failed! $2"